@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -7,6 +8,8 @@
 #include <omp.h>
 #endif
 
+#include <AdamOptimizer.hpp>
+#include <CachedReader.hpp>
 #include <Config.hpp>
 #include <CSVLabelWriter.hpp>
 #include <CSVReader.hpp>
@@ -16,6 +19,10 @@
 #include <NeuralNetwork.hpp>
 #include <NormalGlorotWeightInitializer.hpp>
 #include <NormalHeWeightInitializer.hpp>
+#include <Parallel.hpp>
+#include <ProcessGroup.hpp>
+#include <RMSPropOptimizer.hpp>
+#include <ShardedDenseLayer.hpp>
 #include <SoftmaxDenseOutputLayer.hpp>
 #include <TestDataSoftmaxEvaluator.hpp>
 #include <Timer.hpp>
@@ -54,7 +61,14 @@ int main(int argc, char* argv[]) {  //
 
 #ifdef _OPENMP
   omp_set_num_threads(config.hardThreadsLimit);
-  std::cout << "Parallel computing is enabled.\n" << std::endl;
+  if (config.parallelElementThreshold != 0) {
+    nnn::Parallel::SetElementThreshold(config.parallelElementThreshold);
+  } else {
+    nnn::Parallel::CalibrateElementThreshold();
+  }
+  std::cout << "Parallel computing is enabled (element-wise threshold: " << nnn::Parallel::GetElementThreshold()
+            << " elements).\n"
+            << std::endl;
 #else
   std::cout << "Parallel computing is not enabled (missing OpenMP dependency).\n" << std::endl;
 #endif
@@ -68,7 +82,26 @@ int main(int argc, char* argv[]) {  //
       .weightDecay = config.weightDecay,
       .momentum = config.momentum,
       .epochs = config.epochs,
-      .seed = config.randomSeed});
+      .seed = config.randomSeed,
+      .dataParallelReplicas = config.dataParallelReplicas,
+      .isAsynchronous = config.asynchronousTraining,
+      .pipelineMicroBatches = config.pipelineMicroBatches,
+      .gradientAccumulationSteps = config.gradientAccumulationSteps});
+
+  if (config.optimizer == "adam" || config.optimizer == "adamw") {
+    neuralNetwork.SetOptimizer(std::make_unique<nnn::AdamOptimizer>(nnn::AdamOptimizer::Parameters{
+        .beta1 = config.beta1,
+        .beta2 = config.beta2,
+        .epsilon = config.epsilon,
+        .weightDecay = config.weightDecay,
+        .isWeightDecayDecoupled = config.optimizer == "adamw"}));
+  } else if (config.optimizer == "rmsprop") {
+    neuralNetwork.SetOptimizer(std::make_unique<nnn::RMSPropOptimizer>(nnn::RMSPropOptimizer::Parameters{
+        .decayRate = config.rmspropDecay,
+        .epsilon = config.epsilon,
+        .momentum = config.momentum,
+        .weightDecay = config.weightDecay}));
+  }
 
   if (config.layers.size() < 2) {
     std::cout << "At least two layers are required. Neural network cannot be constructed!" << std::endl;
@@ -76,8 +109,13 @@ int main(int argc, char* argv[]) {  //
   }
 
   for (int i = 0; i < config.layers.size() - 2; ++i) {
-    neuralNetwork.AddHiddenLayer(std::make_unique<nnn::DenseLayer>(
-        config.layers[i], config.layers[i + 1], std::make_unique<nnn::LeakyReLU>(), heInit));
+    if (config.tensorParallelShards > 1) {
+      neuralNetwork.AddHiddenLayer(std::make_unique<nnn::ShardedDenseLayer>(config.layers[i], config.layers[i + 1],
+          std::min(config.tensorParallelShards, config.layers[i + 1]), std::make_unique<nnn::LeakyReLU>(), heInit));
+    } else {
+      neuralNetwork.AddHiddenLayer(std::make_unique<nnn::DenseLayer>(
+          config.layers[i], config.layers[i + 1], std::make_unique<nnn::LeakyReLU>(), heInit));
+    }
   }
   neuralNetwork.SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(
       config.layers[config.layers.size() - 2], config.layers[config.layers.size() - 1], glorotInit));
@@ -85,14 +123,21 @@ int main(int argc, char* argv[]) {  //
   nnn::Timer timer;
   timer.Start();
   std::cout << "Loading dataset..." << std::endl;
-  auto reader = std::make_shared<nnn::CSVReader>();
+  std::shared_ptr<nnn::IReader> reader = std::make_shared<nnn::CSVReader>();
+  if (config.isDatasetCached) {
+    reader = std::make_shared<nnn::CachedReader>(reader);
+  }
 
-  auto datasetResult = nnn::DataLoader::Load({.trainingFeatures = PREFIX + "data/fashion_mnist_train_vectors.csv",
-                                                 .trainingLabels = PREFIX + "data/fashion_mnist_train_labels.csv",
-                                                 .testingFeatures = PREFIX + "data/fashion_mnist_test_vectors.csv",
-                                                 .testingLabels = PREFIX + "data/fashion_mnist_test_labels.csv"},
+  auto datasetResult = nnn::DataLoader::Load({.trainingFeatures = PREFIX + config.trainingFeaturesPath,
+                                                 .trainingLabels = PREFIX + config.trainingLabelsPath,
+                                                 .testingFeatures = PREFIX + config.testingFeaturesPath,
+                                                 .testingLabels = PREFIX + config.testingLabelsPath},
       reader, {.batchSize = config.batchSize, .validationSetFraction = config.validationSetFraction},
-      {.expectedClassNumber = config.expectedClassNumber, .shouldOneHotEncode = true, .normalizationFactor = 256});
+      {.expectedClassNumber = config.expectedClassNumber,
+          .shouldOneHotEncode = true,
+          .normalizationFactor = 256,
+          .isFeatureStorageCompact = config.isFeatureStorageCompact,
+          .areLabelsClassIndices = config.areLabelsClassIndices});
 
   if (datasetResult.has_error()) {
     std::cout << datasetResult.error() << std::endl;
@@ -103,16 +148,42 @@ int main(int argc, char* argv[]) {  //
   timer.Start();
   std::cout << "Training neural network..." << std::endl;
   auto dataset = datasetResult.value();
-  neuralNetwork.Train(dataset.trainingDataset, true);
-  std::cout << "Training took " << timer.End() << " seconds." << std::endl;
+  nnn::NeuralNetwork::Statistics statistics;
+  if (config.processes > 1) {
+    // the trained weights are the same in all processes, the forked ones exit after training
+    auto trainingResult = nnn::ProcessGroup::Launch(
+        config.processes, neuralNetwork.GetParameterCount(), [&](nnn::ProcessGroup& group) {
+          neuralNetwork.SetProcessGroup(&group);
+          statistics = neuralNetwork.Train(dataset.trainingDataset, group.GetRank() == 0);
+          neuralNetwork.SetProcessGroup(nullptr);
+        });
+
+    if (trainingResult.has_error()) {
+      std::cout << trainingResult.error() << std::endl;
+      return -1;
+    }
+  } else {
+    statistics = neuralNetwork.Train(dataset.trainingDataset, true);
+  }
+
+  std::string mode = config.asynchronousTraining && config.dataParallelReplicas > 1 ? "asynchronous" : "synchronous";
+  if (config.processes > 1) {
+    mode += ", " + std::to_string(config.processes) + " processes";
+  }
+  if (config.pipelineMicroBatches > 1) {
+    mode += ", pipelined in " + std::to_string(config.pipelineMicroBatches) + " micro-batches";
+  }
+  std::cout << "Training took " << timer.End() << " seconds (" << static_cast<size_t>(statistics.samplesPerSecond)
+            << " samples/s, " << mode << ")." << std::endl;
 
   timer.Start();
   std::cout << "\nEvaluation of neural network on testing data..." << std::endl;
 
   auto testEval = neuralNetwork.RunForwardPass(*dataset.testingFeatures);
-  auto trainEval = neuralNetwork.RunForwardPass(*dataset.trainingDataset.GetFeatures());
+  auto trainEval =
+      neuralNetwork.Predict(dataset.trainingDataset, 0, dataset.trainingDataset.GetSampleCount() - 1);
 
-  auto evaluation = nnn::TestDataSoftmaxEvaluator::Evaluate(testEval, *dataset.testingLabels);
+  auto evaluation = nnn::TestDataSoftmaxEvaluator::Evaluate(testEval, dataset.GetTestingLabels());
   evaluation.Print();
 
   std::cout << "Evaluation took " << timer.End() << " seconds." << std::endl;
@@ -0,0 +1,32 @@
+#include <cmath>
+
+#include "AdamOptimizer.hpp"
+
+namespace nnn {
+
+  AdamOptimizer::AdamOptimizer(Parameters params) : m_params(params) {}
+
+  void AdamOptimizer::Update(
+      const ParameterBuffers& buffers, size_t count, float learningRate, bool isDecayed, size_t step) {  //
+
+    const float beta1 = m_params.beta1;
+    const float beta2 = m_params.beta2;
+    const float epsilon = m_params.epsilon;
+    // the bias corrections of the step, computed here instead of kept in members shared with concurrent steps
+    const float firstCorrection = 1.0f / (1.0f - std::pow(beta1, static_cast<float>(step)));
+    const float secondCorrection = 1.0f / (1.0f - std::pow(beta2, static_cast<float>(step)));
+
+    // L2 regularization is added to the gradient, decoupled decay shrinks the weights directly
+    const float weightDecay = isDecayed ? m_params.weightDecay : 0.0f;
+    const float l2 = m_params.isWeightDecayDecoupled ? 0.0f : weightDecay;
+    const float decay = m_params.isWeightDecayDecoupled ? 1 - learningRate * weightDecay : 1.0f;
+
+    UpdateElementWise(buffers, count, [=](float& parameter, float gradient, float& firstMoment, float& secondMoment) {
+      const float g = gradient + l2 * parameter;
+      firstMoment = beta1 * firstMoment + (1.0f - beta1) * g;
+      secondMoment = beta2 * secondMoment + (1.0f - beta2) * g * g;
+      const float update = (firstMoment * firstCorrection) / (std::sqrt(secondMoment * secondCorrection) + epsilon);
+      parameter = parameter * decay - learningRate * update;
+    });
+  }
+}  // namespace nnn
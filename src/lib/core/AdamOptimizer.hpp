@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ILayer.hpp"
+#include "IOptimizer.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Adam (https://arxiv.org/abs/1412.6980) with bias-corrected moment estimates. The first moment is kept in
+   * the velocity of the layer.
+   *
+   * With `isWeightDecayDecoupled` the weights are decayed directly as in AdamW (https://arxiv.org/abs/1711.05101),
+   * otherwise the weight decay is added to the gradient (L2 regularization). Biases are not decayed.
+   */
+  class AdamOptimizer : public IOptimizer {
+   public:
+    struct Parameters {
+      float beta1 = 0.9f;
+      float beta2 = 0.999f;
+      float epsilon = 1e-8f;
+      float weightDecay = 0.0f;
+      bool isWeightDecayDecoupled = false;
+    };
+
+    AdamOptimizer(Parameters params);
+
+    void Update(
+        const ParameterBuffers& buffers, size_t count, float learningRate, bool isDecayed, size_t step) override;
+
+   private:
+    Parameters m_params;
+  };
+}  // namespace nnn
@@ -1,5 +1,30 @@
 #include "CrossEntropyWithSoftmax.hpp"
 
-nnn::FloatMatrix nnn::CrossEntropyWithSoftmax::Loss(const FloatMatrix& actual, const FloatMatrix& expected) {
-  return actual - expected;
-}
\ No newline at end of file
+#include <stdexcept>
+#include <string>
+
+#include "FloatMatrixInvalidDimensionException.hpp"
+
+void nnn::CrossEntropyWithSoftmax::LossInto(
+    FloatMatrix& destination, const FloatMatrix& actual, FloatMatrixView expected) {
+  FloatMatrix::AddInto(destination, actual, expected, 1.0f, -1.0f);
+}
+
+void nnn::CrossEntropyWithSoftmax::LossInto(
+    FloatMatrix& destination, const FloatMatrix& actual, std::span<const ClassIndex> expected) {  //
+
+  if (actual.GetColCount() != expected.size()) {
+    throw FloatMatrixInvalidDimensionException(
+        "Cannot compute the loss when the number of class indices does not match.");
+  }
+
+  // the one-hot label is zero everywhere except for the class
+  destination = actual;
+  for (size_t col = 0; col < expected.size(); ++col) {
+    if (expected[col] >= actual.GetRowCount()) {
+      throw std::out_of_range("Class index <" + std::to_string(expected[col]) + "> of sample <" + std::to_string(col) +
+                              "> is out of range.");
+    }
+    destination(expected[col], col) -= 1.0f;
+  }
+}
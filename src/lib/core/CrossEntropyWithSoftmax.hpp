@@ -1,7 +1,10 @@
 #pragma once
 
+#include <span>
+
 #include "FloatMatrix.hpp"
 #include "ILossFunction.hpp"
+#include "LabelsView.hpp"
 
 namespace nnn {
   /**
@@ -15,6 +18,15 @@ namespace nnn {
      * @note Implemented using
      * https://www.geeksforgeeks.org/machine-learning/derivative-of-the-softmax-function-and-the-categorical-cross-entropy-loss/.
      */
-    FloatMatrix Loss(const FloatMatrix& actual, const FloatMatrix& expected) override;
+    void LossInto(FloatMatrix& destination, const FloatMatrix& actual, FloatMatrixView expected) override;
+
+    /**
+     * @brief The same gradient for labels given as class indices: the output with 1 subtracted at the class of every
+     * sample, without reading a one-hot matrix.
+     *
+     * @throws FloatMatrixInvalidDimensionException if the number of indices differs from the number of samples
+     * @throws std::out_of_range if a class index is not a row of the output
+     */
+    static void LossInto(FloatMatrix& destination, const FloatMatrix& actual, std::span<const ClassIndex> expected);
   };
 }  // namespace nnn
@@ -1,38 +1,169 @@
 #include "DataLoader.hpp"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "IdxReader.hpp"
+
+namespace {
+
+  /**
+   * @brief Reads IDX files directly, normalizing features while they are converted, other files with the given reader.
+   */
+  cpp::result<std::shared_ptr<nnn::FloatMatrix>, std::string> ReadFile(
+      const std::filesystem::path& filepath, nnn::IReader& reader, float normalizationFactor) {  //
+
+    if (nnn::IdxReader::IsIdxPath(filepath)) {
+      return nnn::IdxReader(normalizationFactor).Read(filepath);
+    }
+
+    auto result = reader.Read(filepath);
+    if (result.has_value() && normalizationFactor != 1.0f) {
+      result.value()->MapInPlace([normalizationFactor](float x) { return x / normalizationFactor; });
+    }
+    return result;
+  }
+
+  /**
+   * @brief Reads the features as bytes, the values of files other than IDX have to be whole numbers in [0, 255].
+   * The items (rows of the file) become the columns.
+   */
+  cpp::result<std::shared_ptr<nnn::ByteMatrix>, std::string> ReadCompactFile(
+      const std::filesystem::path& filepath, nnn::IReader& reader, float normalizationFactor) {  //
+
+    if (nnn::IdxReader::IsIdxPath(filepath)) {
+      return nnn::IdxReader(normalizationFactor).ReadBytes(filepath);
+    }
+
+    auto result = reader.Read(filepath);
+    if (result.has_error()) {
+      return cpp::fail(result.error());
+    }
+
+    const nnn::FloatMatrix& matrix = *result.value();
+    std::vector<uint8_t> data(matrix.GetSize());
+    for (size_t row = 0; row < matrix.GetRowCount(); ++row) {
+      for (size_t col = 0; col < matrix.GetColCount(); ++col) {
+        const float value = matrix(row, col);
+        if (!(value >= 0.0f && value <= 255.0f) || value != static_cast<float>(static_cast<uint8_t>(value))) {
+          return cpp::fail("Features in <" + filepath.string() + "> cannot be stored compactly, value <" +
+                           std::to_string(value) + "> at line <" + std::to_string(row + 1) +
+                           "> is not a whole number in [0, 255].");
+        }
+        data[row * matrix.GetColCount() + col] = static_cast<uint8_t>(value);
+      }
+    }
+    return std::make_shared<nnn::ByteMatrix>(
+        matrix.GetColCount(), matrix.GetRowCount(), std::move(data), 1.0f / normalizationFactor);
+  }
+
+  /**
+   * @brief Reads labels with a single column as the class indices of the samples.
+   */
+  cpp::result<std::shared_ptr<std::vector<nnn::ClassIndex>>, std::string> ReadClassIndices(
+      const std::filesystem::path& filepath, nnn::IReader& reader, size_t classCount) {  //
+
+    auto result = ReadFile(filepath, reader, 1.0f);
+    if (result.has_error()) {
+      return cpp::fail(result.error());
+    }
+
+    const nnn::FloatMatrix& matrix = *result.value();
+    if (matrix.GetColCount() != 1) {
+      return cpp::fail("Labels in <" + filepath.string() + "> cannot be stored as class indices, they have <" +
+                       std::to_string(matrix.GetColCount()) + "> columns instead of one.");
+    }
+
+    auto classIndices = std::make_shared<std::vector<nnn::ClassIndex>>(matrix.GetRowCount());
+    for (size_t row = 0; row < matrix.GetRowCount(); ++row) {
+      const float value = matrix(row, 0);
+      if (!(value >= 0.0f && value < static_cast<float>(classCount)) ||
+          value != static_cast<float>(static_cast<nnn::ClassIndex>(value))) {
+        return cpp::fail("Labels in <" + filepath.string() + "> cannot be stored as class indices, value <" +
+                         std::to_string(value) + "> at line <" + std::to_string(row + 1) +
+                         "> is not a whole number in [0, " + std::to_string(classCount) + ").");
+      }
+      (*classIndices)[row] = static_cast<nnn::ClassIndex>(value);
+    }
+    return classIndices;
+  }
+}  // namespace
+
 cpp::result<nnn::DataLoader::Dataset, std::string> nnn::DataLoader::Load(const Filepaths& filepaths,
     std::shared_ptr<IReader> reader,
     TrainingParameters trainingParams,
     LoadingParameters loadingParams) {  //
 
-  auto trainingFeaturesReadResult = reader->Read(filepaths.trainingFeatures);
-  if (trainingFeaturesReadResult.has_error()) {
-    return cpp::fail(trainingFeaturesReadResult.error());
-  }
+  const float normFact = loadingParams.normalizationFactor != 0.0f ? loadingParams.normalizationFactor : 1.0f;
 
-  auto trainingLabelsReadResult = reader->Read(filepaths.trainingLabels);
-  if (trainingLabelsReadResult.has_error()) {
-    return cpp::fail(trainingLabelsReadResult.error());
+  // compact features are read instead of the float ones
+  cpp::result<std::shared_ptr<FloatMatrix>, std::string> trainingFeaturesReadResult = nullptr;
+  cpp::result<std::shared_ptr<ByteMatrix>, std::string> compactTrainingFeaturesReadResult = nullptr;
+  if (loadingParams.isFeatureStorageCompact) {
+    compactTrainingFeaturesReadResult = ReadCompactFile(filepaths.trainingFeatures, *reader, normFact);
+    if (compactTrainingFeaturesReadResult.has_error()) {
+      return cpp::fail(compactTrainingFeaturesReadResult.error());
+    }
+  } else {
+    trainingFeaturesReadResult = ReadFile(filepaths.trainingFeatures, *reader, normFact);
+    if (trainingFeaturesReadResult.has_error()) {
+      return cpp::fail(trainingFeaturesReadResult.error());
+    }
   }
 
-  auto testingFeaturesReadResult = reader->Read(filepaths.testingFeatures);
+  auto testingFeaturesReadResult = ReadFile(filepaths.testingFeatures, *reader, normFact);
   if (testingFeaturesReadResult.has_error()) {
     return cpp::fail(testingFeaturesReadResult.error());
   }
 
-  auto testingLabelsReadResult = reader->Read(filepaths.testingLabels);
-  if (testingLabelsReadResult.has_error()) {
-    return cpp::fail(testingLabelsReadResult.error());
+  // adjust for column convention (the compact features have it already)
+  if (!loadingParams.isFeatureStorageCompact) {
+    trainingFeaturesReadResult.value()->Transpose();
+  }
+  testingFeaturesReadResult.value()->Transpose();
+
+  const TrainingDataset::TrainingDatasetParameters datasetParams = {
+      .batchSize = trainingParams.batchSize, .validationSetFraction = trainingParams.validationSetFraction};
+
+  // class indices are used as they are read, no label matrix is created
+  if (loadingParams.areLabelsClassIndices) {  //
+
+    auto trainingClassIndicesReadResult =
+        ReadClassIndices(filepaths.trainingLabels, *reader, loadingParams.expectedClassNumber);
+    if (trainingClassIndicesReadResult.has_error()) {
+      return cpp::fail(trainingClassIndicesReadResult.error());
+    }
+
+    auto testingClassIndicesReadResult =
+        ReadClassIndices(filepaths.testingLabels, *reader, loadingParams.expectedClassNumber);
+    if (testingClassIndicesReadResult.has_error()) {
+      return cpp::fail(testingClassIndicesReadResult.error());
+    }
+
+    TrainingDataset trainingDataset = loadingParams.isFeatureStorageCompact
+                                          ? TrainingDataset(compactTrainingFeaturesReadResult.value(),
+                                                trainingClassIndicesReadResult.value(), datasetParams)
+                                          : TrainingDataset(trainingFeaturesReadResult.value(),
+                                                trainingClassIndicesReadResult.value(), datasetParams);
+
+    return nnn::DataLoader::Dataset{.trainingDataset = trainingDataset,
+        .testingFeatures = testingFeaturesReadResult.value(),
+        .testingClassIndices = testingClassIndicesReadResult.value()};
+  }
+
+  auto trainingLabelsReadResult = ReadFile(filepaths.trainingLabels, *reader, 1.0f);
+  if (trainingLabelsReadResult.has_error()) {
+    return cpp::fail(trainingLabelsReadResult.error());
   }
 
-  const float normFact = loadingParams.normalizationFactor;
-  if (normFact != 1.0f && normFact != 0.0f) {
-    trainingFeaturesReadResult.value()->MapInPlace([normFact](float x) { return x / normFact; });
-    testingFeaturesReadResult.value()->MapInPlace([normFact](float x) { return x / normFact; });
+  auto testingLabelsReadResult = ReadFile(filepaths.testingLabels, *reader, 1.0f);
+  if (testingLabelsReadResult.has_error()) {
+    return cpp::fail(testingLabelsReadResult.error());
   }
 
   // TODO: this could probably be done more efficiently by not loading the whole labels file, just reading it and
-  // creating one-hot encoded data right away
+  // creating one-hot encoded data right away (or not at all, see `areLabelsClassIndices`)
   if (loadingParams.shouldOneHotEncode) {  //
 
     auto rowsTrain = trainingLabelsReadResult.value()->GetRowCount();
@@ -58,14 +189,14 @@ cpp::result<nnn::DataLoader::Dataset, std::string> nnn::DataLoader::Load(const F
     testingLabelsReadResult = newTestLabels;
   }
 
-  // adjust for column convention
-  trainingFeaturesReadResult.value()->Transpose();
-  testingFeaturesReadResult.value()->Transpose();
   trainingLabelsReadResult.value()->Transpose();
   testingLabelsReadResult.value()->Transpose();
 
-  TrainingDataset trainingDataset(trainingFeaturesReadResult.value(), trainingLabelsReadResult.value(),
-      {.batchSize = trainingParams.batchSize, .validationSetFraction = trainingParams.validationSetFraction});
+  TrainingDataset trainingDataset = loadingParams.isFeatureStorageCompact
+                                        ? TrainingDataset(compactTrainingFeaturesReadResult.value(),
+                                              trainingLabelsReadResult.value(), datasetParams)
+                                        : TrainingDataset(trainingFeaturesReadResult.value(),
+                                              trainingLabelsReadResult.value(), datasetParams);
 
   nnn::DataLoader::Dataset finalDataset = {.trainingDataset = trainingDataset,
       .testingFeatures = testingFeaturesReadResult.value(),
@@ -3,11 +3,14 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <result.hpp>
 
+#include "ByteMatrix.hpp"
 #include "FloatMatrix.hpp"
 #include "IReader.hpp"
+#include "LabelsView.hpp"
 #include "TrainingDataset.hpp"
 
 namespace nnn::DataLoader {
@@ -15,9 +18,20 @@ namespace nnn::DataLoader {
   struct Dataset {
     TrainingDataset trainingDataset;
     std::shared_ptr<FloatMatrix> testingFeatures;
-    std::shared_ptr<FloatMatrix> testingLabels;
+    // exactly one of the testing labels is set, see `LoadingParameters::areLabelsClassIndices`
+    std::shared_ptr<FloatMatrix> testingLabels = nullptr;
+    std::shared_ptr<std::vector<ClassIndex>> testingClassIndices = nullptr;
+
+    inline LabelsView GetTestingLabels() const {
+      return testingClassIndices != nullptr ? LabelsView(std::span<const ClassIndex>(*testingClassIndices))
+                                            : LabelsView(*testingLabels);
+    }
   };
 
+  /**
+   * @brief The files of the dataset, IDX files (see `IdxReader::IsIdxPath`) are read by the `IdxReader`, the others by
+   * the reader passed to `Load`.
+   */
   struct Filepaths {
     std::filesystem::path trainingFeatures;
     std::filesystem::path trainingLabels;
@@ -34,6 +48,11 @@ namespace nnn::DataLoader {
     size_t expectedClassNumber = 2;
     bool shouldOneHotEncode = false;
     float normalizationFactor = 1.0f;
+    // the training features are kept as bytes and normalized while the batches are gathered, see `ByteMatrix`
+    bool isFeatureStorageCompact = false;
+    // the labels are kept as the class index of every sample instead of one-hot encoded (`shouldOneHotEncode` is
+    // ignored then), the files have a single whole number in [0, expectedClassNumber) per line
+    bool areLabelsClassIndices = false;
   };
 
   cpp::result<Dataset, std::string> Load(const Filepaths& filepaths,
@@ -1,5 +1,6 @@
 #include "DenseLayer.hpp"
 #include "FloatMatrix.hpp"
+#include "FloatMatrixInvalidDimensionException.hpp"
 #include "IWeightInitializer.hpp"
 
 namespace nnn {
@@ -15,11 +16,15 @@ namespace nnn {
         m_weights(initializer.Initialize(outputSize, inputSize)),
         m_activationFunction(std::move(activationFunction)),
         m_lastInnerPotential(FloatMatrix::Zeroes(outputSize, batchSize)),
-        m_lastInput(FloatMatrix::Zeroes(inputSize, batchSize)),
+        m_lastInput(nullptr, 0, 0, 0, false),
         m_gradientWeights(FloatMatrix::Zeroes(outputSize, inputSize)),
         m_gradientBias(FloatMatrix::Zeroes(outputSize, 1)),
         m_weightVelocity(FloatMatrix::Zeroes(outputSize, inputSize)),
-        m_biasesVelocity(FloatMatrix::Zeroes(outputSize, 1))
+        m_biasesVelocity(FloatMatrix::Zeroes(outputSize, 1)),
+        m_weightSecondMoment(FloatMatrix::Zeroes(outputSize, inputSize)),
+        m_biasesSecondMoment(FloatMatrix::Zeroes(outputSize, 1)),
+        m_output(FloatMatrix::Zeroes(outputSize, batchSize)),
+        m_inputGradient(FloatMatrix::Zeroes(inputSize, batchSize))
 
   {}
 
@@ -31,11 +36,15 @@ namespace nnn {
         m_weights(FloatMatrix::Ones(outputSize, inputSize)),
         m_activationFunction(std::move(activationFunction)),
         m_lastInnerPotential(FloatMatrix::Zeroes(outputSize, batchSize)),
-        m_lastInput(FloatMatrix::Zeroes(inputSize, batchSize)),
+        m_lastInput(nullptr, 0, 0, 0, false),
         m_gradientWeights(FloatMatrix::Zeroes(outputSize, inputSize)),
         m_gradientBias(FloatMatrix::Zeroes(outputSize, 1)),
         m_weightVelocity(FloatMatrix::Zeroes(outputSize, inputSize)),
-        m_biasesVelocity(FloatMatrix::Zeroes(outputSize, 1))
+        m_biasesVelocity(FloatMatrix::Zeroes(outputSize, 1)),
+        m_weightSecondMoment(FloatMatrix::Zeroes(outputSize, inputSize)),
+        m_biasesSecondMoment(FloatMatrix::Zeroes(outputSize, 1)),
+        m_output(FloatMatrix::Zeroes(outputSize, batchSize)),
+        m_inputGradient(FloatMatrix::Zeroes(inputSize, batchSize))
 
   {}
 
@@ -48,32 +57,93 @@ namespace nnn {
       IWeightInitializer& initializer)
       : DenseLayer(1, inputSize, outputSize, std::move(activationFunction), initializer) {}
 
-  FloatMatrix DenseLayer::Forward(const FloatMatrix& inputVector) {  //
-
+  DenseLayer::DenseLayer(const DenseLayer& other)
+      : m_inputSize(other.m_inputSize),
+        m_outputSize(other.m_outputSize),
+        m_weights(other.m_weights),
+        m_biases(other.m_biases),
+        m_activationFunction(other.m_activationFunction->Clone()),
+        m_lastInnerPotential(other.m_lastInnerPotential),
+        m_lastInput(other.m_lastInput),
+        m_gradientWeights(other.m_gradientWeights),
+        m_gradientBias(other.m_gradientBias),
+        m_weightVelocity(other.m_weightVelocity),
+        m_biasesVelocity(other.m_biasesVelocity),
+        m_weightSecondMoment(other.m_weightSecondMoment),
+        m_biasesSecondMoment(other.m_biasesSecondMoment),
+        m_output(other.m_output),
+        m_inputGradient(other.m_inputGradient) {}
+
+  std::unique_ptr<ILayer> DenseLayer::Clone() const { return std::unique_ptr<ILayer>(new DenseLayer(*this)); }
+
+  const FloatMatrix& DenseLayer::Forward(FloatMatrixView inputVector) {  //
+
+    if (m_weights.GetColCount() != inputVector.GetRowCount()) {
+      throw FloatMatrixInvalidDimensionException(
+          "Cannot multiply matrices when column count does not match row count.");
+    }
+
+    // the backward pass reads the input through the view instead of a copy (see `ILayer::Forward`)
     m_lastInput = inputVector;
 
-    auto result = m_weights * inputVector;
-    result.AddToAllCols(m_biases);
-    m_lastInnerPotential = result;
+    const size_t outputSize = m_weights.GetRowCount();
+    const size_t batchSize = inputVector.GetColCount();
+    m_lastInnerPotential.EnsureShape(outputSize, batchSize, false);
+    m_output.EnsureShape(outputSize, batchSize, false);
+
+    // The bias, the inner potential and the activation are applied to each finished block of the product while it is
+    // still in cache, instead of three more passes over the whole output.
+    Gemm::Multiply(outputSize, batchSize, m_weights.GetColCount(), m_weights.AsOperand(), inputVector.AsOperand(),
+        m_output.AsOutput(),
+        {.epilogue = [this](const Gemm::Tile& block) { ApplyForwardEpilogue(block); },
+            .isEpilogueColumnWise = m_activationFunction->IsColumnWise()});
 
-    m_activationFunction->Evaluate(result);
-    return result;
+    return m_output;
   }
 
-  FloatMatrix DenseLayer::Backward(const FloatMatrix& gradient) {
+  void DenseLayer::ApplyForwardEpilogue(const Gemm::Tile& block) {  //
+
+    for (size_t r = block.rowBegin; r < block.rowEnd; ++r) {
+      const float bias = m_biases(r, 0);
+      float* output = m_output.Data() + r * m_output.GetRowStride();
+      float* innerPotential = m_lastInnerPotential.Data() + r * m_lastInnerPotential.GetRowStride();
+
+      for (size_t c = block.colBegin; c < block.colEnd; ++c) {
+        const float value = output[c] + bias;
+        innerPotential[c] = value;
+        output[c] = value;
+      }
+    }
+
+    m_activationFunction->EvaluateBlock(m_output, block);
+  }
+
+  const FloatMatrix& DenseLayer::Backward(const FloatMatrix& gradient) {
     // slide 213
     m_activationFunction->Derivative(m_lastInnerPotential);  // sigma'(inner potential)
-    auto hnc = m_lastInnerPotential.Hadamard(gradient);      // dE/dy * sigma'(inner potential)
-    m_lastInput.Transpose();
 
-    m_gradientWeights = hnc * m_lastInput;  // dE/dw
-    m_gradientBias = FloatMatrix::SumColumns(hnc);
+    // dE/dy * sigma'(inner potential), overwrites the inner potential, which is not needed anymore
+    FloatMatrix::HadamardInto(m_lastInnerPotential, m_lastInnerPotential, gradient);
+    const FloatMatrix& hnc = m_lastInnerPotential;
+
+    FloatMatrix::MultiplyTransBInto(m_gradientWeights, hnc, m_lastInput);  // dE/dw
+    FloatMatrix::SumColumnsInto(m_gradientBias, hnc);
+
+    // dE/dy+1, the final dimensions are rows = input, cols = batch, where input is actually same size as output of next
+    FloatMatrix::MultiplyTransAInto(m_inputGradient, m_weights, hnc);
+    return m_inputGradient;
+  }
+
+  void DenseLayer::BindParameterStorage(const ParameterBuffers& weights, const ParameterBuffers& biases) {
+    m_weights.MoveToExternalStorage(weights.parameters);
+    m_gradientWeights.MoveToExternalStorage(weights.gradients);
+    m_weightVelocity.MoveToExternalStorage(weights.velocities);
+    m_weightSecondMoment.MoveToExternalStorage(weights.secondMoments);
 
-    hnc.Transpose();
-    auto nextGradient = hnc * m_weights;  // dE/dy+1
-    nextGradient.Transpose();
-    return nextGradient;  // here the final dimensions are cols = batch, rows = input, where input is actually same size
-                          // as output of next
+    m_biases.MoveToExternalStorage(biases.parameters);
+    m_gradientBias.MoveToExternalStorage(biases.gradients);
+    m_biasesVelocity.MoveToExternalStorage(biases.velocities);
+    m_biasesSecondMoment.MoveToExternalStorage(biases.secondMoments);
   }
 
   void DenseLayer::Update(const FloatMatrix& weights, const FloatMatrix& biases) {
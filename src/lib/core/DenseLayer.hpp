@@ -29,34 +29,54 @@ namespace nnn {
         std::unique_ptr<IActivationFunction>&& activationFunction,
         IWeightInitializer& initializer);
 
-    FloatMatrix Forward(const FloatMatrix& inputVector) override;
+    std::unique_ptr<ILayer> Clone() const override;
+
+    const FloatMatrix& Forward(FloatMatrixView inputVector) override;
 
     /**
      * @brief ...
      * @param gradient how much does the loss change when my outputs change (dE/dy)
      * @returns how much the loss changes when next layer outputs change (with respect to backward pass)
      */
-    FloatMatrix Backward(const FloatMatrix& gradient) override;
+    const FloatMatrix& Backward(const FloatMatrix& gradient) override;
     void Update(const FloatMatrix& weights, const FloatMatrix& biases) override;
 
     const FloatMatrix& GetWeights() const override;
     const FloatMatrix& GetBiases() const override;
+    inline FloatMatrix& GetWeights() override { return m_weights; }
+    inline FloatMatrix& GetBiases() override { return m_biases; }
     inline const FloatMatrix& GetWeightsGradient() const override { return m_gradientWeights; }
     inline const FloatMatrix& GetBiasesGradient() const override { return m_gradientBias; }
     inline FloatMatrix& GetWeightsVelocity() override { return m_weightVelocity; }
     inline FloatMatrix& GetBiasesVelocity() override { return m_biasesVelocity; }
+    inline FloatMatrix& GetWeightsSecondMoment() override { return m_weightSecondMoment; }
+    inline FloatMatrix& GetBiasesSecondMoment() override { return m_biasesSecondMoment; }
+    void BindParameterStorage(const ParameterBuffers& weights, const ParameterBuffers& biases) override;
 
    protected:
+    DenseLayer(const DenseLayer& other);
+
+    /**
+     * @brief Adds biases, stores the inner potential and evaluates the activation for one block of the forward output.
+     */
+    void ApplyForwardEpilogue(const Gemm::Tile& block);
+
     size_t m_inputSize;
     size_t m_outputSize;
     FloatMatrix m_weights;
     FloatMatrix m_biases;
     std::unique_ptr<IActivationFunction> m_activationFunction;
     FloatMatrix m_lastInnerPotential;
-    FloatMatrix m_lastInput;
+    FloatMatrixView m_lastInput;
     FloatMatrix m_gradientWeights;
     FloatMatrix m_gradientBias;
     FloatMatrix m_weightVelocity;
     FloatMatrix m_biasesVelocity;
+    FloatMatrix m_weightSecondMoment;
+    FloatMatrix m_biasesSecondMoment;
+
+    // Results of the passes, allocated for the batch size and reused, so that a training step does not allocate.
+    FloatMatrix m_output;
+    FloatMatrix m_inputGradient;
   };
 }  // namespace nnn
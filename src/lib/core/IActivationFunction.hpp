@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "FloatMatrix.hpp"
 
 namespace nnn {
@@ -11,11 +13,24 @@ namespace nnn {
    public:
     virtual ~IActivationFunction() = 0;
 
+    virtual std::unique_ptr<IActivationFunction> Clone() const = 0;
+
     /**
      * @brief In-place evaluation of the activation function for the given input.
      */
     virtual void Evaluate(FloatMatrix& input) const = 0;
 
+    /**
+     * @brief In-place evaluation of the activation function on a block of the input only. Used as the epilogue of the
+     * fused matrix multiplication, see `DenseLayer::Forward`.
+     */
+    virtual void EvaluateBlock(FloatMatrix& input, const Gemm::Tile& block) const = 0;
+
+    /**
+     * @brief Whether the activation is not element-wise and `EvaluateBlock` requires blocks spanning whole columns.
+     */
+    virtual bool IsColumnWise() const { return false; }
+
     /**
      * @brief In-place evaluation of the derivate for the given input.
      */
@@ -1,9 +1,26 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+
 #include "FloatMatrix.hpp"
 
 namespace nnn {
 
+  /**
+   * @brief Pointers to the same (block of) parameters in the buffers of a `ParameterArena`.
+   */
+  struct ParameterBuffers {
+    float* parameters;
+    float* gradients;
+    float* velocities;
+    float* secondMoments;
+
+    inline ParameterBuffers Offset(size_t count) const {
+      return {parameters + count, gradients + count, velocities + count, secondMoments + count};
+    }
+  };
+
   /**
    * @brief The core abstraction of the network, the common interface for all layer types.
    */
@@ -11,20 +28,32 @@ namespace nnn {
    public:
     virtual ~ILayer() = 0;
 
+    /**
+     * @brief Deep copy of the layer, including its parameters, their gradients and the optimizer state. Parameters in
+     * external storage (see `BindParameterStorage`) are copied into storage owned by the new layer.
+     */
+    virtual std::unique_ptr<ILayer> Clone() const = 0;
+
     /**
      * @brief Computes the forward pass through the network for the given vector (or a batch).
-     * @return The resulting values given by the last layer of the vector.
+     * @param input view of the input, the layer keeps it for the backward pass, so the input has to stay valid and
+     * unchanged until then (it does not need to for inference).
+     * @return The resulting values given by the last layer of the vector. The matrix is owned by the layer and is
+     * overwritten by the next forward pass.
      */
-    virtual FloatMatrix Forward(const FloatMatrix& input) = 0;
+    virtual const FloatMatrix& Forward(FloatMatrixView input) = 0;
 
     /**
      * @brief Performs backpropagation provided the gradient of the previous layer (in the backward direction).
-     * @return The gradient for the next layer (in the backward direction).
+     * @return The gradient for the next layer (in the backward direction). The matrix is owned by the layer and is
+     * overwritten by the next backward pass.
      */
-    virtual FloatMatrix Backward(const FloatMatrix& gradient) = 0;
+    virtual const FloatMatrix& Backward(const FloatMatrix& gradient) = 0;
 
     virtual const FloatMatrix& GetBiases() const = 0;
     virtual const FloatMatrix& GetWeights() const = 0;
+    virtual FloatMatrix& GetBiases() = 0;
+    virtual FloatMatrix& GetWeights() = 0;
     virtual const FloatMatrix& GetWeightsGradient() const = 0;
     virtual const FloatMatrix& GetBiasesGradient() const = 0;
 
@@ -35,8 +64,20 @@ namespace nnn {
      */
     virtual void Update(const FloatMatrix& weights, const FloatMatrix& biases) = 0;
 
+    // State of the optimizer kept for every parameter: the velocity (the first moment for Adam) and the second moment
+    // (running average of squared gradients, Adam and RMSProp).
+
     virtual FloatMatrix& GetWeightsVelocity() = 0;
     virtual FloatMatrix& GetBiasesVelocity() = 0;
+    virtual FloatMatrix& GetWeightsSecondMoment() = 0;
+    virtual FloatMatrix& GetBiasesSecondMoment() = 0;
+
+    /**
+     * @brief Moves the weights (and biases), their gradients and the optimizer state into the given buffers, each with
+     * room for `GetWeights().GetSize()` (and `GetBiases().GetSize()`) elements. The values are kept, the layer then
+     * works directly in the buffers.
+     */
+    virtual void BindParameterStorage(const ParameterBuffers& weights, const ParameterBuffers& biases) = 0;
   };
 
   inline ILayer::~ILayer() = default;
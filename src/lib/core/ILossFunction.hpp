@@ -10,7 +10,17 @@ namespace nnn {
   class ILossFunction {
    public:
     virtual ~ILossFunction() = 0;
-    virtual FloatMatrix Loss(const FloatMatrix& actual, const FloatMatrix& expected) = 0;
+
+    /**
+     * @brief Writes the gradient of the loss into the destination, reusing its storage.
+     */
+    virtual void LossInto(FloatMatrix& destination, const FloatMatrix& actual, FloatMatrixView expected) = 0;
+
+    FloatMatrix Loss(const FloatMatrix& actual, FloatMatrixView expected) {
+      FloatMatrix result(0, 0);
+      LossInto(result, actual, expected);
+      return result;
+    }
   };
 
   inline ILossFunction::~ILossFunction() = default;
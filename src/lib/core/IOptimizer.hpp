@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "ILayer.hpp"
+#include "Parallel.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief The common interface for the optimizers, which update the parameters of the network from their gradients.
+   * The parameters, the gradients and the state kept per parameter (velocity, moments) live in the ParameterArena of
+   * the network, the optimizer gets them as flat buffers.
+   */
+  class IOptimizer {
+   public:
+    virtual ~IOptimizer() = 0;
+
+    /**
+     * @brief Called once per training step before the parameters are updated, safe to call from several threads at
+     * once (asynchronous training).
+     * @returns the number of the step (starting from 1), to be passed to the updates of the step.
+     */
+    size_t BeginStep() { return m_step.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    /**
+     * @brief Updates `count` consecutive parameters in place. The optimizer does not keep any state between the calls
+     * except for the buffers, so that several steps may update the same parameters at once.
+     * @param learningRate the current (decayed) learning rate.
+     * @param isDecayed whether the weight decay applies to the parameters (it does to the weights, not to the biases).
+     * @param step the number of the step returned by `BeginStep`.
+     */
+    virtual void Update(
+        const ParameterBuffers& buffers, size_t count, float learningRate, bool isDecayed, size_t step) = 0;
+
+   protected:
+    /**
+     * @brief Calls `func(parameter, gradient, firstMoment, secondMoment)` with references to the corresponding elements
+     * of the four buffers, in a single vectorized pass (in parallel for large buffers).
+     */
+    template <typename Func>
+    static void UpdateElementWise(const ParameterBuffers& buffers, size_t count, Func&& func) {  //
+
+      float* w = buffers.parameters;
+      const float* g = buffers.gradients;
+      float* m = buffers.velocities;
+      float* v = buffers.secondMoments;
+      Parallel::ForChunks(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          func(w[i], g[i], m[i], v[i]);
+        }
+      });
+    }
+
+   private:
+    std::atomic<size_t> m_step = 0;
+  };
+
+  inline IOptimizer::~IOptimizer() = default;
+}  // namespace nnn
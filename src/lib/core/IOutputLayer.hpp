@@ -1,7 +1,10 @@
 #pragma once
 
+#include <memory>
+
 #include "FloatMatrix.hpp"
 #include "ILayer.hpp"
+#include "LabelsView.hpp"
 
 namespace nnn {
 
@@ -13,15 +16,20 @@ namespace nnn {
    public:
     virtual ~IOutputLayer() = 0;
 
+    /**
+     * @brief The same as `ILayer::Clone`, keeps the output layer interface.
+     */
+    virtual std::unique_ptr<IOutputLayer> CloneOutputLayer() const = 0;
+
     /**
      * @brief Computes output gradient by using some cost function.
      *
      * @param actual the output of the network on the input.
-     * @param expected the correct labels for the same input.
+     * @param expected the correct labels for the same input (a matrix or class indices).
      *
-     * @returns Gradient vector (averaged if given a batch).
+     * @returns Gradient vector (averaged if given a batch), owned by the layer and overwritten by the next call.
      */
-    virtual FloatMatrix ComputeOutputGradient(const FloatMatrix& actual, const FloatMatrix& expected) = 0;
+    virtual const FloatMatrix& ComputeOutputGradient(const FloatMatrix& actual, LabelsView expected) = 0;
   };
 
   inline IOutputLayer::~IOutputLayer() = default;
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "FloatMatrix.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief The class of a sample as an index, two bytes per sample instead of a float per class (one-hot encoding).
+   */
+  using ClassIndex = uint16_t;
+
+  /**
+   * @brief Non-owning view of the labels of some samples: either a matrix with a column per sample (e.g. one-hot
+   * encoded classes) or the class index of every sample. Matrices and their views convert to it implicitly.
+   *
+   * @warning Like FloatMatrixView, the view does not extend the lifetime of the labels.
+   */
+  class LabelsView {
+   private:
+    FloatMatrixView m_matrix = FloatMatrixView(nullptr, 0, 0, 0, false);
+    std::span<const ClassIndex> m_classIndices;
+    bool m_hasClassIndices = false;
+
+   public:
+    LabelsView(FloatMatrixView matrix) : m_matrix(matrix) {}
+    LabelsView(const FloatMatrix& matrix) : m_matrix(matrix.View()) {}
+    LabelsView(std::span<const ClassIndex> classIndices) : m_classIndices(classIndices), m_hasClassIndices(true) {}
+
+    inline bool HasClassIndices() const { return m_hasClassIndices; }
+    inline size_t GetSampleCount() const {
+      return m_hasClassIndices ? m_classIndices.size() : m_matrix.GetColCount();
+    }
+
+    /**
+     * @brief The label matrix, empty (0x0) when the labels are class indices.
+     */
+    inline FloatMatrixView GetMatrix() const { return m_matrix; }
+
+    /**
+     * @brief The class indices, empty when the labels are a matrix.
+     */
+    inline std::span<const ClassIndex> GetClassIndices() const { return m_classIndices; }
+
+    /**
+     * @brief Returns the view of the labels of samples [begin, end] (no data is copied).
+     */
+    inline LabelsView GetColumns(size_t begin, size_t end) const {
+      return m_hasClassIndices ? LabelsView(m_classIndices.subspan(begin, end - begin + 1))
+                               : LabelsView(m_matrix.GetColumns(begin, end));
+    }
+  };
+}  // namespace nnn
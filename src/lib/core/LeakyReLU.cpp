@@ -8,6 +8,11 @@ void nnn::LeakyReLU::Evaluate(FloatMatrix& input) const {
   input.MapInPlace([alpha](float x) { return x > 0 ? x : x * alpha; });
 }
 
+void nnn::LeakyReLU::EvaluateBlock(FloatMatrix& input, const Gemm::Tile& block) const {
+  const float alpha = m_alpha;
+  input.MapInPlace(block, [alpha](float x) { return x > 0 ? x : x * alpha; });
+}
+
 void nnn::LeakyReLU::Derivative(FloatMatrix& input) const {
   const float alpha = m_alpha;
   input.MapInPlace([alpha](float x) { return x > 0 ? 1 : alpha; });
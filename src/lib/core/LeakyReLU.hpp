@@ -9,7 +9,9 @@ namespace nnn {
    public:
     LeakyReLU() = default;
     LeakyReLU(float alpha);
+    inline std::unique_ptr<IActivationFunction> Clone() const override { return std::make_unique<LeakyReLU>(*this); }
     void Evaluate(FloatMatrix& input) const override;
+    void EvaluateBlock(FloatMatrix& input, const Gemm::Tile& block) const override;
     void Derivative(FloatMatrix& input) const override;
 
    private:
@@ -1,5 +1,6 @@
 #include "MSE.hpp"
 
-nnn::FloatMatrix nnn::MSE::Loss(const FloatMatrix& actual, const FloatMatrix& expected) {
-  return (actual - expected) * 2.0f;
+void nnn::MSE::LossInto(FloatMatrix& destination, const FloatMatrix& actual, FloatMatrixView expected) {
+  // scaling by two is exact, so this equals 2 * (actual - expected)
+  FloatMatrix::AddInto(destination, actual, expected, 2.0f, -2.0f);
 }
\ No newline at end of file
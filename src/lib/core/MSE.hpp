@@ -7,6 +7,6 @@ namespace nnn {
   class MSE : public ILossFunction {
    public:
     MSE() = default;
-    FloatMatrix Loss(const FloatMatrix& actual, const FloatMatrix& expected) override;
+    void LossInto(FloatMatrix& destination, const FloatMatrix& actual, FloatMatrixView expected) override;
   };
 }  // namespace nnn
@@ -0,0 +1,21 @@
+#include "MomentumOptimizer.hpp"
+
+namespace nnn {
+
+  MomentumOptimizer::MomentumOptimizer(float momentum, float weightDecay)
+      : m_momentum(momentum), m_weightDecay(weightDecay) {}
+
+  void MomentumOptimizer::Update(
+      const ParameterBuffers& buffers, size_t count, float learningRate, bool isDecayed, size_t) {  //
+
+    const float momentum = m_momentum;
+    const float decay = isDecayed ? 1 - learningRate * m_weightDecay : 1.0f;
+
+    // the second moment is not used
+    UpdateElementWise(buffers, count, [=](float& parameter, float gradient, float& velocity, float&) {
+      const float newVelocity = velocity * momentum + gradient;
+      velocity = newVelocity;
+      parameter = parameter * decay - newVelocity * learningRate;
+    });
+  }
+}  // namespace nnn
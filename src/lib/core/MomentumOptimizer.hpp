@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ILayer.hpp"
+#include "IOptimizer.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Stochastic gradient descent with momentum and weight decay (biases are not decayed):
+   * velocity = momentum * velocity + gradient, weights = (1 - learningRate * weightDecay) * weights - learningRate *
+   * velocity.
+   */
+  class MomentumOptimizer : public IOptimizer {
+   public:
+    MomentumOptimizer(float momentum, float weightDecay);
+
+    void Update(
+        const ParameterBuffers& buffers, size_t count, float learningRate, bool isDecayed, size_t step) override;
+
+   private:
+    float m_momentum;
+    float m_weightDecay;
+  };
+}  // namespace nnn
@@ -1,17 +1,34 @@
 #include "NeuralNetwork.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <exception>
 #include <iomanip>
 #include <iostream>
+#include <span>
 
+#include "Parallel.hpp"
 #include "TestDataSoftmaxEvaluator.hpp"
+#include "Timer.hpp"
 
-static float ComputeCrossEntropyLoss(const nnn::FloatMatrix& predictions, const nnn::FloatMatrix& labels) {  //
+static float ComputeCrossEntropyLoss(const nnn::FloatMatrix& predictions, nnn::LabelsView labels) {  //
+
+  // only the probability of the labelled class counts, a single logarithm per sample
+  if (labels.HasClassIndices()) {
+    const std::span<const nnn::ClassIndex> classIndices = labels.GetClassIndices();
+    float total = 0.0f;
+    for (size_t col = 0; col < classIndices.size(); ++col) {
+      total += std::log(std::max(1e-10f, std::min(1.0f - 1e-10f, predictions(classIndices[col], col))));
+    }
+    return -total / classIndices.size();
+  }
 
   nnn::FloatMatrix logPredictions =
       predictions.Map([](float x) { return std::log(std::max(1e-10f, std::min(1.0f - 1e-10f, x))); });
 
-  auto loss = labels.Hadamard(logPredictions);
+  nnn::FloatMatrix loss(0, 0);
+  nnn::FloatMatrix::HadamardInto(loss, labels.GetMatrix(), logPredictions);
   loss.Transpose();
 
   auto flat = nnn::FloatMatrix::SumColumns(loss);
@@ -25,38 +42,352 @@ namespace nnn {
 
   size_t NeuralNetwork::AddHiddenLayer(std::unique_ptr<ILayer>&& layer) {
     m_hiddenLayers.push_back(std::move(layer));
+    m_parameterArena.Invalidate();
+    m_replicas.clear();
+    m_accumulatedSamples = 0;
     return m_hiddenLayers.size() - 1;
   }
 
   size_t NeuralNetwork::SetOutputLayer(std::unique_ptr<IOutputLayer>&& layer) {
     m_outputLayer = std::move(layer);
+    m_parameterArena.Invalidate();
+    m_replicas.clear();
+    m_accumulatedSamples = 0;
     return m_hiddenLayers.size();
   }
 
-  FloatMatrix NeuralNetwork::RunForwardPass(FloatMatrix input) {
-    ForEachLayerForward([&](ILayer& layer) { input = layer.Forward(input); });
-    return input;
+  const FloatMatrix& NeuralNetwork::RunForwardPass(FloatMatrixView input) {  //
+
+    // the first layer reads the input through the view, the following ones read the output of the previous layer
+    const FloatMatrix* output = nullptr;
+    ForEachLayerForward([&](ILayer& layer) { output = &layer.Forward(output ? output->View() : input); });
+    return *output;
+  }
+
+  const FloatMatrix& NeuralNetwork::Predict(const TrainingDataset& dataset, size_t begin, size_t end) {  //
+
+    // compact features are converted and evaluated in chunks, so that neither the float features nor the activations
+    // of the whole range are allocated at once
+    constexpr size_t COMPACT_CHUNK_SIZE = 4096;
+    const size_t count = end + 1 - begin;
+    const size_t chunkSize = dataset.HasCompactFeatures() ? COMPACT_CHUNK_SIZE : count;
+
+    for (size_t first = begin; first <= end && count > 0; first += chunkSize) {  //
+
+      const size_t last = std::min(end, first + chunkSize - 1);
+      const FloatMatrix& output = RunForwardPass(dataset.GetFeatureColumns(first, last, m_batchFeatures));
+      if (first == begin && last == end) {
+        return output;
+      }
+
+      m_predictions.EnsureShape(output.GetRowCount(), count);
+      for (size_t row = 0; row < output.GetRowCount(); ++row) {
+        for (size_t col = 0; col < output.GetColCount(); ++col) {
+          m_predictions(row, first - begin + col) = output(row, col);
+        }
+      }
+    }
+    return m_predictions;
+  }
+
+  void NeuralNetwork::RunBackwardPass(const FloatMatrix& gradient) {
+    const FloatMatrix* current = &gradient;
+    ForEachLayerBackward([&](ILayer& layer) { current = &layer.Backward(*current); });
   }
 
-  void NeuralNetwork::RunBackwardPass(FloatMatrix gradient) {
-    ForEachLayerBackward([&](ILayer& layer) { gradient = layer.Backward(gradient); });
+  void NeuralNetwork::SetOptimizer(std::unique_ptr<IOptimizer>&& optimizer) { m_optimizer = std::move(optimizer); }
+
+  void NeuralNetwork::BindParameterArena() {  //
+
+    if (!m_parameterArena.IsBound()) {
+      std::vector<ILayer*> layers;
+      ForEachLayerForward([&](ILayer& layer) { layers.push_back(&layer); });
+      m_parameterArena.Bind(layers);
+    }
   }
 
   void NeuralNetwork::UpdateWeights() {  //
 
-    ForEachLayerForward([&](ILayer& layer) {
-      FloatMatrix& weightVelocity = layer.GetWeightsVelocity();
-      FloatMatrix& biasVelocity = layer.GetBiasesVelocity();
+    BindParameterArena();
+
+    ApplyGradients(m_parameterArena, m_optimizer->BeginStep());
+  }
+
+  void NeuralNetwork::ApplyGradients(ParameterArena& arena, size_t step) {
+    // all weights and all biases are contiguous, so each is updated in a single pass
+    m_optimizer->Update(arena.GetWeights(), arena.GetWeightCount(), m_params.learningRate, true, step);
+    m_optimizer->Update(arena.GetBiases(), arena.GetBiasCount(), m_params.learningRate, false, step);
+  }
+
+  void NeuralNetwork::ComputeGradients(FloatMatrixView features, LabelsView labels, float batchSize) {  //
+
+    const FloatMatrix& actual = RunForwardPass(features);
+    RunBackwardPass(ComputeOutputGradient(actual, labels, batchSize));
+  }
+
+  const FloatMatrix& NeuralNetwork::ComputeOutputGradient(
+      const FloatMatrix& actual, LabelsView labels, float batchSize) {  //
+
+    // copied into a persistent buffer (the storage is reused), so that it can be averaged in place
+    m_outputGradient = m_outputLayer->ComputeOutputGradient(actual, labels);
+    m_outputGradient.MapInPlace([batchSize](float x) { return x / batchSize; });
+    return m_outputGradient;
+  }
+
+  void NeuralNetwork::RunTrainingStep(FloatMatrixView features, LabelsView labels) {  //
+
+    ComputeBatchGradients(features, labels);
+    ApplyBatchGradients(features.GetColCount());
+  }
+
+  void NeuralNetwork::AccumulateGradients(FloatMatrixView features, LabelsView labels) {  //
+
+    ComputeBatchGradients(features, labels);
+
+    // the gradients are averages over their batches, weighted by the batch sizes they sum up to the window total
+    BindParameterArena();
+    const size_t size = m_parameterArena.GetSize();
+    const float* gradients = m_parameterArena.GetGradients();
+    const float weight = static_cast<float>(features.GetColCount());
+    const bool isFirst = m_accumulatedSamples == 0;
+    m_accumulatedGradients.resize(size);
+    float* accumulated = m_accumulatedGradients.data();
+
+    Parallel::ForChunks(size, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        accumulated[i] = (isFirst ? 0.0f : accumulated[i]) + weight * gradients[i];
+      }
+    });
+    m_accumulatedSamples += features.GetColCount();
+  }
+
+  void NeuralNetwork::ApplyAccumulatedGradients() {  //
+
+    if (m_accumulatedSamples == 0) {
+      return;
+    }
+
+    BindParameterArena();
+    float* gradients = m_parameterArena.GetGradients();
+    const float* accumulated = m_accumulatedGradients.data();
+    const float scale = 1.0f / static_cast<float>(m_accumulatedSamples);
+
+    Parallel::ForChunks(m_parameterArena.GetSize(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        gradients[i] = accumulated[i] * scale;
+      }
+    });
+
+    ApplyBatchGradients(m_accumulatedSamples);
+    m_accumulatedSamples = 0;
+  }
+
+  void NeuralNetwork::ComputeBatchGradients(FloatMatrixView features, LabelsView labels) {  //
 
-      weightVelocity = weightVelocity * m_params.momentum + layer.GetWeightsGradient();
-      biasVelocity = biasVelocity * m_params.momentum + layer.GetBiasesGradient();
+    if (m_params.pipelineMicroBatches > 1) {
+      ComputeGradientsPipelined(features, labels);
+    } else if (m_params.dataParallelReplicas > 1) {
+      ComputeGradientsDataParallel(features, labels);
+    } else {
+      ComputeGradients(features, labels, static_cast<float>(features.GetColCount()));
+    }
+  }
+
+  void NeuralNetwork::ApplyBatchGradients(size_t sampleCount) {  //
+
+    // the shards of the processes may differ in size by one column, so the average is weighted
+    if (m_processGroup != nullptr) {
+      BindParameterArena();
+      m_processGroup->AllReduceAverage(
+          m_parameterArena.GetGradients(), m_parameterArena.GetSize(), static_cast<float>(sampleCount));
+    }
+    UpdateWeights();
+  }
+
+  void NeuralNetwork::ComputeGradientsDataParallel(FloatMatrixView features, LabelsView labels) {  //
+
+    // every replica gets a contiguous range of columns, the last batch of an epoch may have fewer columns than replicas
+    const size_t batchSize = features.GetColCount();
+    const size_t workers = std::min(m_params.dataParallelReplicas, batchSize);
+    PrepareReplicas(workers);
+    Parallel::ForEachWorker(workers, [&](size_t worker) {
+      NeuralNetwork& replica = worker == 0 ? *this : *m_replicas[worker - 1];
+      const size_t begin = worker * batchSize / workers;
+      const size_t end = (worker + 1) * batchSize / workers - 1;
+      replica.ComputeGradients(
+          features.GetColumns(begin, end), labels.GetColumns(begin, end), static_cast<float>(batchSize));
+    });
+
+    ReduceReplicaGradients(workers);
+  }
+
+  void NeuralNetwork::TrainEpochAsynchronously(const TrainingBatchGenerator& batchGenerator) {  //
+
+    PrepareReplicas(m_params.dataParallelReplicas);
 
-      FloatMatrix newWeights = layer.GetWeights() * (1 - m_params.learningRate * m_params.weightDecay) -
-                               weightVelocity * m_params.learningRate;
-      FloatMatrix newBiases = layer.GetBiases() - biasVelocity * m_params.learningRate;
+    std::atomic<size_t> cursor = 0;
+    const size_t batchCount = batchGenerator.GetBatchCount();
+    Parallel::ForEachWorker(m_params.dataParallelReplicas, [&](size_t worker) {
+      NeuralNetwork& replica = worker == 0 ? *this : *m_replicas[worker - 1];
 
-      layer.Update(newWeights, newBiases);
+      for (size_t index = cursor++; index < batchCount; index = cursor++) {
+        auto batch = batchGenerator.GetBatch(
+            index, replica.m_batchFeatures, replica.m_batchLabels, replica.m_batchClassIndices);
+        replica.ComputeGradients(batch.features, batch.labels, static_cast<float>(batch.features.GetColCount()));
+
+        // only the step counter of the optimizer is atomic, the parameters are updated without locks
+        ApplyGradients(replica.m_parameterArena, m_optimizer->BeginStep());
+      }
+    });
+  }
+
+  void NeuralNetwork::ComputeGradientsPipelined(FloatMatrixView features, LabelsView labels) {  //
+
+    const size_t batchSize = features.GetColCount();
+    const size_t microBatches = std::min(m_params.pipelineMicroBatches, batchSize);
+    const size_t stages = m_hiddenLayers.size() + 1;
+    PrepareReplicas(microBatches);
+
+    // Every micro-batch runs through the layers of its own replica, which keep its activations until its backward
+    // pass. Entry [microBatch * stages + stage] is the result of the stage (layer) for the micro-batch.
+    m_pipelineOutputs.assign(microBatches * stages, nullptr);
+    m_pipelineGradients.assign(microBatches * stages, nullptr);
+
+    // the number of micro-batches each stage has finished, a stage waits for its neighbour to get ahead of it
+    if (m_pipelineForwardProgress.size() != stages) {
+      m_pipelineForwardProgress = std::vector<std::atomic<size_t>>(stages);
+      m_pipelineBackwardProgress = std::vector<std::atomic<size_t>>(stages);
+    }
+    std::vector<std::atomic<size_t>>& forwardProgress = m_pipelineForwardProgress;
+    std::vector<std::atomic<size_t>>& backwardProgress = m_pipelineBackwardProgress;
+    for (size_t stage = 0; stage < stages; ++stage) {
+      forwardProgress[stage].store(0, std::memory_order_relaxed);
+      backwardProgress[stage].store(0, std::memory_order_relaxed);
+    }
+    std::atomic<bool> isAborted = false;
+    std::exception_ptr error = nullptr;
+
+    auto waitFor = [&isAborted](std::atomic<size_t>& progress, size_t count) {
+      for (size_t current = progress.load(std::memory_order_acquire); current < count && !isAborted;
+           current = progress.load(std::memory_order_acquire)) {
+        progress.wait(current, std::memory_order_acquire);
+      }
+      return !isAborted;
+    };
+
+    auto publish = [](std::atomic<size_t>& progress, size_t count) {
+      progress.store(count, std::memory_order_release);
+      progress.notify_all();
+    };
+
+    auto replicaOf = [this](size_t microBatch) -> NeuralNetwork& {
+      return microBatch == 0 ? *this : *m_replicas[microBatch - 1];
+    };
+
+    // GPipe schedule: every stage runs the forward pass of all micro-batches, then their backward passes, while the
+    // neighbouring stages work on the neighbouring micro-batches
+    const bool isPipelined = Parallel::TryForEachConcurrentWorker(stages, [&](size_t stage) {
+      try {
+        for (size_t microBatch = 0; microBatch < microBatches; ++microBatch) {
+          if (stage > 0 && !waitFor(forwardProgress[stage - 1], microBatch + 1)) {
+            return;
+          }
+          const size_t begin = microBatch * batchSize / microBatches;
+          const size_t end = (microBatch + 1) * batchSize / microBatches - 1;
+          FloatMatrixView input =
+              stage == 0 ? features.GetColumns(begin, end) : m_pipelineOutputs[microBatch * stages + stage - 1]->View();
+          m_pipelineOutputs[microBatch * stages + stage] = &replicaOf(microBatch).GetLayer(stage)->Forward(input);
+          publish(forwardProgress[stage], microBatch + 1);
+        }
+
+        for (size_t microBatch = 0; microBatch < microBatches; ++microBatch) {
+          NeuralNetwork& replica = replicaOf(microBatch);
+          const FloatMatrix* gradient = nullptr;
+          if (stage == stages - 1) {
+            const size_t begin = microBatch * batchSize / microBatches;
+            const size_t end = (microBatch + 1) * batchSize / microBatches - 1;
+            gradient = &replica.ComputeOutputGradient(*m_pipelineOutputs[microBatch * stages + stage],
+                labels.GetColumns(begin, end), static_cast<float>(batchSize));
+          } else {
+            if (!waitFor(backwardProgress[stage + 1], microBatch + 1)) {
+              return;
+            }
+            gradient = m_pipelineGradients[microBatch * stages + stage + 1];
+          }
+          m_pipelineGradients[microBatch * stages + stage] = &replica.GetLayer(stage)->Backward(*gradient);
+          publish(backwardProgress[stage], microBatch + 1);
+        }
+      } catch (...) {
+        // the first failure is rethrown, the other stages are woken up and stop
+        if (!isAborted.exchange(true)) {
+          error = std::current_exception();
+        }
+        for (size_t other = 0; other < stages; ++other) {
+          forwardProgress[other].fetch_add(1);
+          forwardProgress[other].notify_all();
+          backwardProgress[other].fetch_add(1);
+          backwardProgress[other].notify_all();
+        }
+      }
     });
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+
+    // without a thread per stage the stages would wait for each other forever, the micro-batches run one by one then
+    if (!isPipelined) {
+      for (size_t microBatch = 0; microBatch < microBatches; ++microBatch) {
+        const size_t begin = microBatch * batchSize / microBatches;
+        const size_t end = (microBatch + 1) * batchSize / microBatches - 1;
+        replicaOf(microBatch).ComputeGradients(
+            features.GetColumns(begin, end), labels.GetColumns(begin, end), static_cast<float>(batchSize));
+      }
+    }
+    ReduceReplicaGradients(microBatches);
+  }
+
+  void NeuralNetwork::PrepareReplicas(size_t count) {  //
+
+    BindParameterArena();
+    while (m_replicas.size() + 1 < count) {
+      m_replicas.push_back(CreateReplica());
+    }
+  }
+
+  std::unique_ptr<NeuralNetwork> NeuralNetwork::CreateReplica() {  //
+
+    auto replica = std::make_unique<NeuralNetwork>(m_params);
+    for (const auto& layer : m_hiddenLayers) {
+      replica->m_hiddenLayers.push_back(layer->Clone());
+    }
+    replica->m_outputLayer = m_outputLayer->CloneOutputLayer();
+
+    std::vector<ILayer*> layers;
+    replica->ForEachLayerForward([&](ILayer& layer) { layers.push_back(&layer); });
+    replica->m_parameterArena.BindShared(layers, m_parameterArena);
+    return replica;
+  }
+
+  void NeuralNetwork::ReduceReplicaGradients(size_t count) {  //
+
+    auto gradients = [this](size_t replica) {
+      return replica == 0 ? m_parameterArena.GetGradients() : m_replicas[replica - 1]->m_parameterArena.GetGradients();
+    };
+
+    // pairwise: after the level with the given distance, replica i (a multiple of 2 * distance) holds the sum of the
+    // replicas [i, i + 2 * distance), so the sum ends in replica 0 after log2(count) levels
+    for (size_t distance = 1; distance < count; distance *= 2) {
+      Parallel::ForChunks(m_parameterArena.GetSize(), [&](size_t begin, size_t end) {
+        for (size_t target = 0; target + distance < count; target += 2 * distance) {
+          float* sum = gradients(target);
+          const float* other = gradients(target + distance);
+          for (size_t i = begin; i < end; ++i) {
+            sum[i] += other[i];
+          }
+        }
+      });
+    }
   }
 
   // TODO: this method is now unfortunetely tighly coupled with softmax output layer, see ComputeCrossEntropyLoss()
@@ -68,35 +399,60 @@ namespace nnn {
     lossesValidation.reserve(m_params.epochs);
     lossesTraining.reserve(m_params.epochs);
 
-    FloatMatrix allTrainFeatures = trainingDataset.GetTrainingFeatures();
-    FloatMatrix allTrainLabels = trainingDataset.GetTrainingLabels();
-    FloatMatrix allValidationFeatures = trainingDataset.GetValidationFeatures();
-    FloatMatrix allValidationLabels = trainingDataset.GetValidationLabels();
-
-    TrainingBatchGenerator batchGenerator(trainingDataset, {.isDataShufflingEnabled = true, .seed = m_params.seed});
+    LabelsView allTrainLabels = trainingDataset.GetTrainingLabels();
+    LabelsView allValidationLabels = trainingDataset.GetValidationLabels();
+    const size_t trainingSampleCount = trainingDataset.GetTrainingSampleCount();
+
+    // with a process group, all processes shuffle the same way and each takes its own part of every batch
+    TrainingBatchGenerator batchGenerator(trainingDataset,
+        {.isDataShufflingEnabled = true,
+            .seed = m_params.seed,
+            .shardIndex = m_processGroup != nullptr ? m_processGroup->GetRank() : 0,
+            .shardCount = m_processGroup != nullptr ? m_processGroup->GetSize() : 1});
+    const size_t batchSize = trainingDataset.GetBatchSize();
+    size_t trainedSamples = 0;
+    Timer::Second trainingSeconds = 0;
+    Timer timer;
 
     for (size_t epoch = 0; epoch < m_params.epochs; ++epoch) {  //
 
-      while (batchGenerator.HasNextBatch()) {  //
-
-        TrainingBatchGenerator::TrainingBatch trainingBatch = batchGenerator.GetNextBatch();
-        FloatMatrix actual = RunForwardPass(trainingBatch.features);
-        FloatMatrix gradient = m_outputLayer->ComputeOutputGradient(actual, trainingBatch.labels);
-        gradient.MapInPlace([trainingBatch](float x) { return x / trainingBatch.features.GetColCount(); });
-        RunBackwardPass(gradient);
-        UpdateWeights();
+      timer.Start();
+      if (m_params.isAsynchronous && m_params.dataParallelReplicas > 1 && m_processGroup == nullptr) {
+        TrainEpochAsynchronously(batchGenerator);
+      } else {
+        size_t accumulatedBatches = 0;
+        while (batchGenerator.HasNextBatch()) {  //
+
+          TrainingBatchGenerator::TrainingBatch trainingBatch = batchGenerator.GetNextBatch();
+          if (m_params.gradientAccumulationSteps > 1) {
+            AccumulateGradients(trainingBatch.features, trainingBatch.labels);
+            if (++accumulatedBatches == m_params.gradientAccumulationSteps) {
+              ApplyAccumulatedGradients();
+              accumulatedBatches = 0;
+            }
+          } else {
+            RunTrainingStep(trainingBatch.features, trainingBatch.labels);
+          }
+        }
+        // the last window of the epoch may be shorter
+        ApplyAccumulatedGradients();
       }
+      trainingSeconds += timer.End();
+
+      // all batches are full, across all processes
+      trainedSamples += batchGenerator.GetBatchCount() * batchSize;
 
       batchGenerator.Reset();
 
-      FloatMatrix trainPredictions = RunForwardPass(allTrainFeatures);
+      const FloatMatrix& trainPredictions = Predict(trainingDataset, 0, trainingSampleCount - 1);
       float trainLoss = ComputeCrossEntropyLoss(trainPredictions, allTrainLabels);
 
       lossesTraining.push_back(trainLoss);
 
       if (trainingDataset.HasValidationDataset() && reportProgress) {  //
 
-        FloatMatrix actual = RunForwardPass(allValidationFeatures);
+        const FloatMatrix& actual =
+            Predict(trainingDataset, trainingSampleCount, trainingDataset.GetSampleCount() - 1);
         float validationLoss = ComputeCrossEntropyLoss(actual, allValidationLabels);
 
         auto validationEval = TestDataSoftmaxEvaluator::Evaluate(actual, allValidationLabels);
@@ -107,15 +463,26 @@ namespace nnn {
         std::cout << "Epoch " << epoch + 1 << "/" << m_params.epochs << "\t- loss training: " << trainLoss;
         std::cout << ", validation: " << validationLoss;
         std::cout << std::setprecision(2) << " (aprox. " << percentValidation * 100 << "%)";
+        std::cout << std::setprecision(0) << ", " << trainedSamples / trainingSeconds << " samples/s";
         std::cout << "." << std::endl;
       }
 
       m_params.learningRate *= m_params.learningRateDecay;
     }
 
-    return {lossesTraining, lossesValidation};
+    const float samplesPerSecond = trainingSeconds > 0 ? static_cast<float>(trainedSamples / trainingSeconds) : 0.0f;
+    return {lossesTraining, lossesValidation, samplesPerSecond};
   }
 
+  size_t NeuralNetwork::GetParameterCount() const {
+    size_t count = 0;
+    ForEachLayerForward(
+        [&](const ILayer& layer) { count += layer.GetWeights().GetSize() + layer.GetBiases().GetSize(); });
+    return count;
+  }
+
+  void NeuralNetwork::SetProcessGroup(ProcessGroup* group) { m_processGroup = group; }
+
   ILayer* NeuralNetwork::GetLayer(size_t index) {  //
 
     if (index > m_hiddenLayers.size()) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -7,7 +8,12 @@
 
 #include "FloatMatrix.hpp"
 #include "ILayer.hpp"
+#include "IOptimizer.hpp"
 #include "IOutputLayer.hpp"
+#include "LabelsView.hpp"
+#include "MomentumOptimizer.hpp"
+#include "ParameterArena.hpp"
+#include "ProcessGroup.hpp"
 #include "TrainingDataset.hpp"
 
 namespace nnn {
@@ -24,11 +30,24 @@ namespace nnn {
       float momentum = 0.0f;
       size_t epochs = 30;
       int seed = 42;
+      // the batch is split between this many model replicas, each trained on its own thread
+      size_t dataParallelReplicas = 1;
+      // Hogwild: instead of splitting batches, every replica trains on whole batches of its own and updates the shared
+      // weights without any locking (nondeterministic, requires more than one replica)
+      bool isAsynchronous = false;
+      // with more than one, every layer runs on its own thread and the batch is streamed through the layers in this
+      // many micro-batches (GPipe)
+      size_t pipelineMicroBatches = 1;
+      // the weights are updated once per this many batches with their averaged gradients, so the effective batch is
+      // larger than the memory of the activations (not used by the asynchronous mode)
+      size_t gradientAccumulationSteps = 1;
     };
 
     struct Statistics {
       std::vector<float> trainingLosses;
       std::vector<float> validationLosses;
+      // training throughput, without the evaluation after each epoch
+      float samplesPerSecond = 0.0f;
 
       void Print(int stride = 0) const;
     };
@@ -38,17 +57,141 @@ namespace nnn {
 
     size_t AddHiddenLayer(std::unique_ptr<ILayer>&& layer);
     size_t SetOutputLayer(std::unique_ptr<IOutputLayer>&& layer);
+
+    /**
+     * @brief Replaces the optimizer, by default momentum SGD configured by the hyperparameters is used.
+     */
+    void SetOptimizer(std::unique_ptr<IOptimizer>&& optimizer);
     ILayer* GetLayer(size_t index);
+    size_t GetParameterCount() const;
+
+    /**
+     * @brief Synchronous training across the processes of the group (or a single process for nullptr): every process
+     * trains on its shard of each batch and the gradients are averaged by an all-reduce before every weight update.
+     * The asynchronous mode is not available across processes.
+     */
+    void SetProcessGroup(ProcessGroup* group);
+
+    /**
+     * @brief The parameters of all layers, bound on the first weight update after the structure has changed.
+     */
+    const ParameterArena& GetParameterArena() const { return m_parameterArena; }
 
     Statistics Train(TrainingDataset& trainingDataset, bool reportProgress = false);
-    FloatMatrix RunForwardPass(FloatMatrix input);
-    void RunBackwardPass(FloatMatrix gradient);
+
+    /**
+     * @brief Forward pass, backward pass and weight update for a single batch. Once the layers have seen a batch of
+     * the same size, the step does not allocate any memory.
+     *
+     * With more than one data-parallel replica, every replica computes the gradients of its share of the batch on its
+     * own thread, the gradients are summed by a tree reduction and the shared weights are updated once.
+     */
+    void RunTrainingStep(FloatMatrixView features, LabelsView labels);
+
+    /**
+     * @brief Forward and backward pass for a single batch, its gradients are added to those accumulated since the
+     * last `ApplyAccumulatedGradients`, weighted by the batch size.
+     */
+    void AccumulateGradients(FloatMatrixView features, LabelsView labels);
+
+    /**
+     * @brief Updates the weights once with the average of the accumulated gradients (nothing when there are none).
+     */
+    void ApplyAccumulatedGradients();
+
+    /**
+     * @returns the output of the last layer, owned by the layer and overwritten by the next forward pass.
+     */
+    const FloatMatrix& RunForwardPass(FloatMatrixView input);
+
+    /**
+     * @returns the outputs of the network for the samples [begin, end] of the dataset, also for compact features.
+     * Owned by the network (or its last layer) and overwritten by the next forward pass or prediction.
+     */
+    const FloatMatrix& Predict(const TrainingDataset& dataset, size_t begin, size_t end);
+    void RunBackwardPass(const FloatMatrix& gradient);
     void UpdateWeights();
 
    protected:
     HyperParameters m_params = HyperParameters();
     std::vector<std::unique_ptr<ILayer>> m_hiddenLayers;
     std::unique_ptr<IOutputLayer> m_outputLayer;
+    std::unique_ptr<IOptimizer> m_optimizer =
+        std::make_unique<MomentumOptimizer>(m_params.momentum, m_params.weightDecay);
+    FloatMatrix m_outputGradient = FloatMatrix(0, 0);
+    ParameterArena m_parameterArena;
+
+    // Copies of the layers for data-parallel training, sharing the parameters of this network (which is replica 0).
+    std::vector<std::unique_ptr<NeuralNetwork>> m_replicas;
+    ProcessGroup* m_processGroup = nullptr;
+    // weighted sum of the gradients of the batches since the last update, see `AccumulateGradients`
+    FloatMatrix::Storage m_accumulatedGradients;
+    size_t m_accumulatedSamples = 0;
+    // results of each layer for each micro-batch of the pipeline
+    std::vector<const FloatMatrix*> m_pipelineOutputs;
+    std::vector<const FloatMatrix*> m_pipelineGradients;
+    // the number of micro-batches each stage has finished in its forward and backward passes
+    std::vector<std::atomic<size_t>> m_pipelineForwardProgress;
+    std::vector<std::atomic<size_t>> m_pipelineBackwardProgress;
+    // batches gathered by this replica in the asynchronous mode
+    FloatMatrix m_batchFeatures = FloatMatrix(0, 0);
+    FloatMatrix m_batchLabels = FloatMatrix(0, 0);
+    std::vector<ClassIndex> m_batchClassIndices;
+    // outputs of `Predict` when the samples are evaluated in several chunks
+    FloatMatrix m_predictions = FloatMatrix(0, 0);
+
+    void BindParameterArena();
+
+    /**
+     * @brief Forward and backward pass, the output gradient is divided by `batchSize` (the size of the whole batch,
+     * when the features are only a part of it).
+     */
+    void ComputeGradients(FloatMatrixView features, LabelsView labels, float batchSize);
+
+    /**
+     * @brief Gradients of the batch averaged over its columns, computed as configured (data-parallel, pipelined or by
+     * this network alone).
+     */
+    void ComputeBatchGradients(FloatMatrixView features, LabelsView labels);
+
+    /**
+     * @brief Averages the gradients across the process group (if any) and updates the weights.
+     * @param sampleCount the number of samples the gradients of this process are averaged over.
+     */
+    void ApplyBatchGradients(size_t sampleCount);
+
+    /**
+     * @returns the gradient of the loss for the output of the last layer, divided by `batchSize`.
+     */
+    const FloatMatrix& ComputeOutputGradient(const FloatMatrix& actual, LabelsView labels, float batchSize);
+    void ComputeGradientsDataParallel(FloatMatrixView features, LabelsView labels);
+
+    /**
+     * @brief Pipeline-parallel forward and backward pass: layer k runs on its own thread and works on micro-batch i + 1
+     * while layer k + 1 works on micro-batch i. Every micro-batch uses its own replica, the gradients of the
+     * micro-batches are summed at the end. When OpenMP does not provide a thread per layer, the micro-batches are
+     * processed one after another (with the same result).
+     */
+    void ComputeGradientsPipelined(FloatMatrixView features, LabelsView labels);
+
+    /**
+     * @brief Updates the weights from the gradients in the given arena (of this network or of one of its replicas) as
+     * a part of the given optimizer step (see `IOptimizer::BeginStep`).
+     */
+    void ApplyGradients(ParameterArena& arena, size_t step);
+
+    /**
+     * @brief One epoch of Hogwild training: every replica takes the next batch from a shared atomic cursor, computes
+     * its gradients and applies them to the shared weights, while the other replicas may be reading or updating them.
+     */
+    void TrainEpochAsynchronously(const TrainingBatchGenerator& batchGenerator);
+    void PrepareReplicas(size_t count);
+    std::unique_ptr<NeuralNetwork> CreateReplica();
+
+    /**
+     * @brief Sums the gradients of the first `count` replicas into the gradients of this network.
+     */
+    void ReduceReplicaGradients(size_t count);
 
     virtual void ForEachLayerForwardImpl(const std::function<void(ILayer&)>& func) {
       for (auto& layer : m_hiddenLayers) {
@@ -78,24 +221,26 @@ namespace nnn {
       }
     }
 
+    // The callable is passed by reference, std::function stores the reference wrapper in place instead of allocating a
+    // copy of a lambda with many captures.
     template <typename Function>
     void ForEachLayerForward(Function&& func) {
-      ForEachLayerForwardImpl(std::function<void(ILayer&)>(std::forward<Function>(func)));
+      ForEachLayerForwardImpl(std::function<void(ILayer&)>(std::ref(func)));
     }
 
     template <typename Function>
     void ForEachLayerForward(Function&& func) const {
-      ForEachLayerForwardImpl(std::function<void(const ILayer&)>(std::forward<Function>(func)));
+      ForEachLayerForwardImpl(std::function<void(const ILayer&)>(std::ref(func)));
     }
 
     template <typename Function>
     void ForEachLayerBackward(Function&& func) {
-      ForEachLayerBackwardImpl(std::function<void(ILayer&)>(std::forward<Function>(func)));
+      ForEachLayerBackwardImpl(std::function<void(ILayer&)>(std::ref(func)));
     }
 
     template <typename Function>
     void ForEachLayerBackward(Function&& func) const {
-      ForEachLayerBackwardImpl(std::function<void(const ILayer&)>(std::forward<Function>(func)));
+      ForEachLayerBackwardImpl(std::function<void(const ILayer&)>(std::ref(func)));
     }
   };
 }  // namespace nnn
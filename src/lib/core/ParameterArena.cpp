@@ -0,0 +1,69 @@
+#include "ParameterArena.hpp"
+
+#include <utility>
+
+namespace nnn {
+
+  static size_t CountWeights(const std::vector<ILayer*>& layers) {
+    size_t count = 0;
+    for (const ILayer* layer : layers) {
+      count += layer->GetWeights().GetSize();
+    }
+    return count;
+  }
+
+  static void BindLayers(const std::vector<ILayer*>& layers, const ParameterBuffers& buffers, size_t weightCount) {  //
+
+    ParameterBuffers weights = buffers;
+    ParameterBuffers biases = buffers.Offset(weightCount);
+    for (ILayer* layer : layers) {
+      const size_t layerWeightCount = layer->GetWeights().GetSize();
+      const size_t layerBiasCount = layer->GetBiases().GetSize();
+      layer->BindParameterStorage(weights, biases);
+      weights = weights.Offset(layerWeightCount);
+      biases = biases.Offset(layerBiasCount);
+    }
+  }
+
+  void ParameterArena::Bind(const std::vector<ILayer*>& layers) {  //
+
+    const size_t weightCount = CountWeights(layers);
+    size_t size = weightCount;
+    for (const ILayer* layer : layers) {
+      size += layer->GetBiases().GetSize();
+    }
+
+    // The layers may still live in the old buffers, they are released only after everything was copied.
+    FloatMatrix::Storage parameters(size);
+    FloatMatrix::Storage gradients(size);
+    FloatMatrix::Storage velocities(size);
+    FloatMatrix::Storage secondMoments(size);
+
+    const ParameterBuffers buffers = {parameters.data(), gradients.data(), velocities.data(), secondMoments.data()};
+    BindLayers(layers, buffers, weightCount);
+
+    m_parameters = std::move(parameters);
+    m_gradients = std::move(gradients);
+    m_velocities = std::move(velocities);
+    m_secondMoments = std::move(secondMoments);
+    m_buffers = buffers;
+    m_weightCount = weightCount;
+    m_isBound = true;
+  }
+
+  void ParameterArena::BindShared(const std::vector<ILayer*>& layers, ParameterArena& shared) {  //
+
+    FloatMatrix::Storage gradients(shared.GetSize());
+    ParameterBuffers buffers = shared.GetWeights();
+    buffers.gradients = gradients.data();
+    BindLayers(layers, buffers, shared.GetWeightCount());
+
+    m_parameters = {};
+    m_gradients = std::move(gradients);
+    m_velocities = {};
+    m_secondMoments = {};
+    m_buffers = buffers;
+    m_weightCount = shared.GetWeightCount();
+    m_isBound = true;
+  }
+}  // namespace nnn
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "FloatMatrix.hpp"
+#include "ILayer.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Contiguous storage of all trainable parameters of a network: one buffer of parameters, one of gradients and
+   * one for each kind of optimizer state, all with the same layout. All weights are stored first (layer by layer),
+   * followed by all biases, so that each group can be updated by the optimizer in a single pass and the whole state can
+   * be saved or reduced as one buffer.
+   */
+  class ParameterArena {
+   public:
+    /**
+     * @brief (Re)allocates the buffers for the given layers and moves their parameters in, keeping the values.
+     */
+    void Bind(const std::vector<ILayer*>& layers);
+
+    /**
+     * @brief Binds the layers of a replica of the network bound to `shared`: the parameters and the optimizer state are
+     * those of `shared`, only the gradients are kept in this arena. The layers have to be copies of the layers of
+     * `shared`, their values are written into its buffers.
+     */
+    void BindShared(const std::vector<ILayer*>& layers, ParameterArena& shared);
+
+    inline bool IsBound() const { return m_isBound; }
+
+    /**
+     * @brief Marks the arena as outdated (e.g. a layer was added), the buffers stay valid until the next `Bind`.
+     */
+    inline void Invalidate() { m_isBound = false; }
+
+    inline size_t GetSize() const { return m_gradients.size(); }
+    inline size_t GetWeightCount() const { return m_weightCount; }
+    inline size_t GetBiasCount() const { return GetSize() - m_weightCount; }
+
+    inline const float* GetParameters() const { return m_buffers.parameters; }
+    inline const float* GetGradients() const { return m_gradients.data(); }
+    inline float* GetGradients() { return m_gradients.data(); }
+
+    inline ParameterBuffers GetWeights() { return m_buffers; }
+    inline ParameterBuffers GetBiases() { return GetWeights().Offset(m_weightCount); }
+
+   private:
+    FloatMatrix::Storage m_parameters;
+    FloatMatrix::Storage m_gradients;
+    FloatMatrix::Storage m_velocities;
+    FloatMatrix::Storage m_secondMoments;
+    ParameterBuffers m_buffers = {};
+    size_t m_weightCount = 0;
+    bool m_isBound = false;
+  };
+}  // namespace nnn
@@ -0,0 +1,219 @@
+#include "ProcessGroup.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define NNN_HAS_FORK
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+  /**
+   * @brief Thrown in the processes waiting for a process which failed, the failed process reports the error itself.
+   */
+  class ProcessGroupAbortedException : public std::runtime_error {
+   public:
+    ProcessGroupAbortedException() : std::runtime_error("Another training process failed.") {}
+  };
+
+  // the slots start on their own cache lines
+  constexpr size_t SLOT_ALIGNMENT = 64 / sizeof(float);
+}  // namespace
+
+namespace nnn {
+
+  struct ProcessGroup::SharedState {
+    std::atomic<size_t> arrivedCount = 0;
+    std::atomic<size_t> generation = 0;
+    std::atomic<bool> isAborted = false;
+    // the process which failed first
+    std::atomic<size_t> failedRank = SIZE_MAX;
+  };
+
+  static_assert(std::atomic<size_t>::is_always_lock_free && std::atomic<bool>::is_always_lock_free,
+      "The atomics in shared memory must not use a process-local lock.");
+
+  ProcessGroup::ProcessGroup(SharedState* state, float* slots, size_t slotSize, size_t rank, size_t size)
+      : m_state(state), m_slots(slots), m_slotSize(slotSize), m_rank(rank), m_size(size) {}
+
+  int ProcessGroup::RunBody(ProcessGroup& group, const std::function<void(ProcessGroup&)>& body) {  //
+
+    try {
+      body(group);
+      return 0;
+    } catch (const ProcessGroupAbortedException&) {
+      return 1;
+    } catch (const std::exception& e) {
+      std::cerr << "Training process " << group.GetRank() << " failed: " << e.what() << std::endl;
+    } catch (...) {
+      std::cerr << "Training process " << group.GetRank() << " failed." << std::endl;
+    }
+
+    group.Abort();
+    return 1;
+  }
+
+  cpp::result<void, std::string> ProcessGroup::Launch(
+      size_t processCount, size_t maxElementCount, const std::function<void(ProcessGroup&)>& body) {  //
+
+    if (processCount == 0) {
+      return cpp::fail("At least one training process is required.");
+    }
+
+#ifdef NNN_HAS_FORK
+    // one more element for the weight, which is reduced together with the data
+    const size_t slotSize = (maxElementCount + 1 + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+    const size_t stateSize = (sizeof(SharedState) + 63) / 64 * 64;
+    const size_t mappingSize = stateSize + processCount * slotSize * sizeof(float);
+
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+      return cpp::fail("Failed to map shared memory for training processes: " + std::string(std::strerror(errno)));
+    }
+    SharedState* state = new (mapping) SharedState();
+    float* slots = reinterpret_cast<float*>(static_cast<char*>(mapping) + stateSize);
+
+#ifdef _OPENMP
+    const int threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+
+    // anything still buffered would be written by every process
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    std::string error;
+    std::vector<pid_t> children;
+    for (size_t rank = 1; rank < processCount; ++rank) {
+      const pid_t pid = fork();
+      if (pid == 0) {
+        ProcessGroup group(state, slots, slotSize, rank, processCount);
+        const int status = RunBody(group, body);
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        _exit(status);
+      }
+
+      if (pid < 0) {
+        error = "Failed to start training process " + std::to_string(rank) + ": " + std::strerror(errno);
+        state->isAborted = true;
+        break;
+      }
+      children.push_back(pid);
+    }
+
+    if (error.empty()) {
+      ProcessGroup group(state, slots, slotSize, 0, processCount);
+      RunBody(group, body);
+    }
+
+    for (size_t i = 0; i < children.size(); ++i) {
+      int status = 0;
+      waitpid(children[i], &status, 0);
+      if (!WIFEXITED(status) && state->failedRank == SIZE_MAX) {
+        state->failedRank = i + 1;
+      }
+    }
+
+    if (error.empty() && state->failedRank != SIZE_MAX) {
+      error = "Training process " + std::to_string(state->failedRank.load()) + " failed.";
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+
+    state->~SharedState();
+    munmap(mapping, mappingSize);
+
+    if (!error.empty()) {
+      return cpp::fail(error);
+    }
+    return {};
+#else
+    return cpp::fail("Multi-process training is only supported on POSIX systems.");
+#endif
+  }
+
+  void ProcessGroup::Barrier() {  //
+
+    const size_t generation = m_state->generation.load(std::memory_order_acquire);
+    if (m_state->arrivedCount.fetch_add(1, std::memory_order_acq_rel) + 1 == m_size) {
+      m_state->arrivedCount.store(0, std::memory_order_relaxed);
+      m_state->generation.fetch_add(1, std::memory_order_release);
+      return;
+    }
+
+    while (m_state->generation.load(std::memory_order_acquire) == generation) {
+      if (m_state->isAborted.load(std::memory_order_relaxed)) {
+        throw ProcessGroupAbortedException();
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void ProcessGroup::Abort() {
+    size_t noRank = SIZE_MAX;
+    m_state->failedRank.compare_exchange_strong(noRank, m_rank);
+    m_state->isAborted = true;
+  }
+
+  void ProcessGroup::AllReduceAverage(float* data, size_t count, float weight) {  //
+
+    if (count >= m_slotSize) {
+      throw std::invalid_argument("Cannot all-reduce more elements than the shared memory of the group holds.");
+    }
+
+    const size_t total = count + 1;
+    float* own = GetSlot(m_rank);
+    const float* left = GetSlot((m_rank + m_size - 1) % m_size);
+    auto chunkBegin = [total, this](size_t chunk) { return chunk * total / m_size; };
+
+    for (size_t i = 0; i < count; ++i) {
+      own[i] = data[i] * weight;
+    }
+    own[count] = weight;
+    Barrier();
+
+    // In step s, process r adds chunk (r - 1 - s) of its left neighbour, which the neighbour finished in step s - 1.
+    // Afterwards process r holds the complete sum of chunk r + 1.
+    for (size_t step = 0; step + 1 < m_size; ++step) {
+      const size_t chunk = (m_rank + 2 * m_size - 1 - step) % m_size;
+      for (size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i) {
+        own[i] += left[i];
+      }
+      Barrier();
+    }
+
+    // In step s, process r copies the complete chunk (r - s) from its left neighbour.
+    for (size_t step = 0; step + 1 < m_size; ++step) {
+      const size_t chunk = (m_rank + m_size - step) % m_size;
+      std::copy(left + chunkBegin(chunk), left + chunkBegin(chunk + 1), own + chunkBegin(chunk));
+      Barrier();
+    }
+
+    const float scale = 1.0f / own[count];
+    for (size_t i = 0; i < count; ++i) {
+      data[i] = own[i] * scale;
+    }
+  }
+}  // namespace nnn
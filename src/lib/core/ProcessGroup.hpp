@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include <result.hpp>
+
+namespace nnn {
+
+  /**
+   * @brief A group of training processes on one machine, started by forking the current process. The processes
+   * exchange data through a POSIX shared memory mapping created before the fork, no MPI is needed.
+   *
+   * @warning The OpenMP thread pool of a process cannot be used after a fork, so every process of the group runs
+   * single-threaded (the processes take the place of the threads) and must not start threads of its own, e.g. through
+   * data-parallel replicas.
+   */
+  class ProcessGroup {
+   public:
+    /**
+     * @brief Forks `processCount - 1` processes and runs `body` in each of them and in the calling process (rank 0).
+     * The forked processes exit when the body returns, the call returns once all of them exited.
+     *
+     * @param maxElementCount the largest number of elements passed to `AllReduceAverage`.
+     * @return an error if a process could not be started or the body failed in any of the processes (the failed
+     * process reports the details to the error output, the others stop at their next exchange). A process killed by a
+     * signal is not detected by the processes waiting for it.
+     */
+    static cpp::result<void, std::string> Launch(
+        size_t processCount, size_t maxElementCount, const std::function<void(ProcessGroup&)>& body);
+
+    inline size_t GetRank() const { return m_rank; }
+    inline size_t GetSize() const { return m_size; }
+
+    /**
+     * @brief Replaces the data in every process by the weighted average over all processes, sum(weight * data) /
+     * sum(weight), the result is identical in all processes. Ring all-reduce: the data is split into one chunk per
+     * process, each chunk is summed while it travels once around the ring (reduce-scatter) and the finished chunks
+     * travel around once more (all-gather). Every process only reads the shared slot of its left neighbour.
+     *
+     * @throws std::runtime_error if another process of the group failed
+     */
+    void AllReduceAverage(float* data, size_t count, float weight);
+
+   private:
+    struct SharedState;
+
+    SharedState* m_state;
+    float* m_slots;
+    size_t m_slotSize;
+    size_t m_rank;
+    size_t m_size;
+
+    ProcessGroup(SharedState* state, float* slots, size_t slotSize, size_t rank, size_t size);
+
+    static int RunBody(ProcessGroup& group, const std::function<void(ProcessGroup&)>& body);
+
+    inline float* GetSlot(size_t rank) const { return m_slots + rank * m_slotSize; }
+
+    /**
+     * @brief Waits until all processes arrive.
+     * @throws std::runtime_error if another process of the group failed
+     */
+    void Barrier();
+    void Abort();
+  };
+}  // namespace nnn
@@ -0,0 +1,25 @@
+#include <cmath>
+
+#include "RMSPropOptimizer.hpp"
+
+namespace nnn {
+
+  RMSPropOptimizer::RMSPropOptimizer(Parameters params) : m_params(params) {}
+
+  void RMSPropOptimizer::Update(
+      const ParameterBuffers& buffers, size_t count, float learningRate, bool isDecayed, size_t) {  //
+
+    const float decayRate = m_params.decayRate;
+    const float epsilon = m_params.epsilon;
+    const float momentum = m_params.momentum;
+
+    const float l2 = isDecayed ? m_params.weightDecay : 0.0f;
+
+    UpdateElementWise(buffers, count, [=](float& parameter, float gradient, float& velocity, float& meanSquare) {
+      const float g = gradient + l2 * parameter;
+      meanSquare = decayRate * meanSquare + (1.0f - decayRate) * g * g;
+      velocity = momentum * velocity + g / (std::sqrt(meanSquare) + epsilon);
+      parameter -= learningRate * velocity;
+    });
+  }
+}  // namespace nnn
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ILayer.hpp"
+#include "IOptimizer.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief RMSProp, the gradient is divided by the root of the running average of its square. With a non-zero momentum
+   * the scaled gradient is accumulated in the velocity of the layer. The weight decay is added to the gradient (L2
+   * regularization), biases are not decayed.
+   */
+  class RMSPropOptimizer : public IOptimizer {
+   public:
+    struct Parameters {
+      float decayRate = 0.99f;
+      float epsilon = 1e-8f;
+      float momentum = 0.0f;
+      float weightDecay = 0.0f;
+    };
+
+    RMSPropOptimizer(Parameters params);
+
+    void Update(
+        const ParameterBuffers& buffers, size_t count, float learningRate, bool isDecayed, size_t step) override;
+
+   private:
+    Parameters m_params;
+  };
+}  // namespace nnn
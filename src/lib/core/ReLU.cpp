@@ -9,6 +9,10 @@ namespace nnn {
     input.MapInPlace([](float x) { return std::max(x, 0.0f); });
   }
 
+  void ReLU::EvaluateBlock(FloatMatrix& input, const Gemm::Tile& block) const {
+    input.MapInPlace(block, [](float x) { return std::max(x, 0.0f); });
+  }
+
   void ReLU::Derivative(FloatMatrix& input) const {
     input.MapInPlace([](float x) { return x > 0 ? 1 : 0; });
   }
@@ -8,7 +8,9 @@ namespace nnn {
   class ReLU : public IActivationFunction {
    public:
     ReLU() = default;
+    inline std::unique_ptr<IActivationFunction> Clone() const override { return std::make_unique<ReLU>(*this); }
     void Evaluate(FloatMatrix& input) const override;
+    void EvaluateBlock(FloatMatrix& input, const Gemm::Tile& block) const override;
     void Derivative(FloatMatrix& input) const override;
   };
 }  // namespace nnn
@@ -0,0 +1,184 @@
+#include "ShardedDenseLayer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "DenseLayer.hpp"
+#include "FloatMatrixInvalidDimensionException.hpp"
+#include "Parallel.hpp"
+
+namespace nnn {
+
+  ShardedDenseLayer::ShardedDenseLayer(size_t batchSize,
+      size_t inputSize,
+      size_t outputSize,
+      size_t shardCount,
+      std::unique_ptr<IActivationFunction>&& activationFunction,
+      IWeightInitializer& initializer)
+      : m_inputSize(inputSize),
+        m_outputSize(outputSize),
+        m_weights(initializer.Initialize(outputSize, inputSize)),
+        m_biases(FloatMatrix::Zeroes(outputSize, 1)),
+        m_gradientWeights(FloatMatrix::Zeroes(outputSize, inputSize)),
+        m_gradientBias(FloatMatrix::Zeroes(outputSize, 1)),
+        m_weightVelocity(FloatMatrix::Zeroes(outputSize, inputSize)),
+        m_biasesVelocity(FloatMatrix::Zeroes(outputSize, 1)),
+        m_weightSecondMoment(FloatMatrix::Zeroes(outputSize, inputSize)),
+        m_biasesSecondMoment(FloatMatrix::Zeroes(outputSize, 1)),
+        m_output(FloatMatrix::Zeroes(outputSize, batchSize)),
+        m_inputGradient(FloatMatrix::Zeroes(inputSize, batchSize)) {  //
+
+    if (activationFunction->IsColumnWise()) {
+      throw std::invalid_argument("A sharded dense layer requires an element-wise activation function.");
+    }
+    if (shardCount == 0 || shardCount > outputSize) {
+      throw std::invalid_argument("A sharded dense layer needs between 1 and output size shards.");
+    }
+
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+      m_shardRows.push_back(shard * outputSize / shardCount);
+      const size_t rows = (shard + 1) * outputSize / shardCount - m_shardRows.back();
+      m_shards.push_back(std::make_unique<DenseLayer>(batchSize, inputSize, rows, activationFunction->Clone()));
+      m_shardGradients.push_back(FloatMatrix::Zeroes(rows, batchSize));
+    }
+    m_shardRows.push_back(outputSize);
+    m_shardInputGradients.resize(shardCount, nullptr);
+
+    BindOwnStorage();
+  }
+
+  ShardedDenseLayer::ShardedDenseLayer(size_t inputSize,
+      size_t outputSize,
+      size_t shardCount,
+      std::unique_ptr<IActivationFunction>&& activationFunction,
+      IWeightInitializer& initializer)
+      : ShardedDenseLayer(1, inputSize, outputSize, shardCount, std::move(activationFunction), initializer) {}
+
+  ShardedDenseLayer::ShardedDenseLayer(const ShardedDenseLayer& other)
+      : m_inputSize(other.m_inputSize),
+        m_outputSize(other.m_outputSize),
+        m_shardRows(other.m_shardRows),
+        m_weights(other.m_weights),
+        m_biases(other.m_biases),
+        m_gradientWeights(other.m_gradientWeights),
+        m_gradientBias(other.m_gradientBias),
+        m_weightVelocity(other.m_weightVelocity),
+        m_biasesVelocity(other.m_biasesVelocity),
+        m_weightSecondMoment(other.m_weightSecondMoment),
+        m_biasesSecondMoment(other.m_biasesSecondMoment),
+        m_output(other.m_output),
+        m_inputGradient(other.m_inputGradient),
+        m_shardGradients(other.m_shardGradients),
+        m_shardInputGradients(other.m_shardInputGradients.size(), nullptr) {  //
+
+    for (const auto& shard : other.m_shards) {
+      m_shards.push_back(shard->Clone());
+    }
+    BindOwnStorage();
+  }
+
+  std::unique_ptr<ILayer> ShardedDenseLayer::Clone() const {
+    return std::unique_ptr<ILayer>(new ShardedDenseLayer(*this));
+  }
+
+  void ShardedDenseLayer::BindOwnStorage() {  //
+
+    const size_t weightCount = m_outputSize * m_inputSize;
+    const size_t parameterCount = weightCount + m_outputSize;
+    m_ownStorage.assign(4 * parameterCount, 0.0f);
+
+    float* data = m_ownStorage.data();
+    const ParameterBuffers buffers = {
+        data, data + parameterCount, data + 2 * parameterCount, data + 3 * parameterCount};
+    BindParameterStorage(buffers, buffers.Offset(weightCount));
+  }
+
+  void ShardedDenseLayer::BindParameterStorage(const ParameterBuffers& weights, const ParameterBuffers& biases) {  //
+
+    // The shards are bound to their blocks first, the values of the whole matrices are moved in afterwards, so that
+    // they win over the (initial) values of the shards.
+    for (size_t shard = 0; shard < m_shards.size(); ++shard) {
+      m_shards[shard]->BindParameterStorage(
+          weights.Offset(m_shardRows[shard] * m_inputSize), biases.Offset(m_shardRows[shard]));
+    }
+
+    m_weights.MoveToExternalStorage(weights.parameters);
+    m_gradientWeights.MoveToExternalStorage(weights.gradients);
+    m_weightVelocity.MoveToExternalStorage(weights.velocities);
+    m_weightSecondMoment.MoveToExternalStorage(weights.secondMoments);
+
+    m_biases.MoveToExternalStorage(biases.parameters);
+    m_gradientBias.MoveToExternalStorage(biases.gradients);
+    m_biasesVelocity.MoveToExternalStorage(biases.velocities);
+    m_biasesSecondMoment.MoveToExternalStorage(biases.secondMoments);
+
+    // the storage of the layer is not needed anymore once it lives in an arena
+    if (weights.parameters != m_ownStorage.data()) {
+      FloatMatrix::Storage().swap(m_ownStorage);
+    }
+  }
+
+  const FloatMatrix& ShardedDenseLayer::Forward(FloatMatrixView input) {  //
+
+    if (m_inputSize != input.GetRowCount()) {
+      throw FloatMatrixInvalidDimensionException(
+          "Cannot multiply matrices when column count does not match row count.");
+    }
+
+    const size_t batchSize = input.GetColCount();
+    m_output.EnsureShape(m_outputSize, batchSize, false);
+
+    // every shard computes its rows of the output and copies them into the output of the layer, the shards keep a view
+    // of the input (not a copy, see `DenseLayer::Forward`), so it is stored once whatever the number of shards
+    Parallel::ForEachWorker(m_shards.size(), [&](size_t shard) {
+      const FloatMatrix& output = m_shards[shard]->Forward(input);
+      for (size_t row = 0; row < output.GetRowCount(); ++row) {
+        for (size_t col = 0; col < batchSize; ++col) {
+          m_output(m_shardRows[shard] + row, col) = output(row, col);
+        }
+      }
+    });
+
+    return m_output;
+  }
+
+  const FloatMatrix& ShardedDenseLayer::Backward(const FloatMatrix& gradient) {  //
+
+    const size_t batchSize = gradient.GetColCount();
+    const size_t shardCount = m_shards.size();
+
+    // every shard back-propagates its rows of the gradient, its input gradient is a partial sum over its outputs
+    Parallel::ForEachWorker(shardCount, [&](size_t shard) {
+      FloatMatrix& shardGradient = m_shardGradients[shard];
+      shardGradient.EnsureShape(m_shardRows[shard + 1] - m_shardRows[shard], batchSize, false);
+      for (size_t row = 0; row < shardGradient.GetRowCount(); ++row) {
+        for (size_t col = 0; col < batchSize; ++col) {
+          shardGradient(row, col) = gradient(m_shardRows[shard] + row, col);
+        }
+      }
+      m_shardInputGradients[shard] = &m_shards[shard]->Backward(shardGradient);
+    });
+
+    // reduce-scatter of the partial sums: every thread sums its block of rows over all shards, in the shard order
+    m_inputGradient.EnsureShape(m_inputSize, batchSize, false);
+    Parallel::ForEachWorker(std::min(shardCount, m_inputSize), [&](size_t worker) {
+      const size_t workers = std::min(shardCount, m_inputSize);
+      for (size_t row = worker * m_inputSize / workers; row < (worker + 1) * m_inputSize / workers; ++row) {
+        for (size_t col = 0; col < batchSize; ++col) {
+          float sum = 0.0f;
+          for (size_t shard = 0; shard < shardCount; ++shard) {
+            sum += (*m_shardInputGradients[shard])(row, col);
+          }
+          m_inputGradient(row, col) = sum;
+        }
+      }
+    });
+
+    return m_inputGradient;
+  }
+
+  void ShardedDenseLayer::Update(const FloatMatrix& weights, const FloatMatrix& biases) {
+    m_weights = weights;
+    m_biases = biases;
+  }
+}  // namespace nnn
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "FloatMatrix.hpp"
+#include "IActivationFunction.hpp"
+#include "ILayer.hpp"
+#include "IWeightInitializer.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Dense layer split by output rows into shards (tensor parallelism), for layers so wide that their matrix
+   * multiplications dominate the training step. Every shard is a `DenseLayer` computing its block of the outputs on its
+   * own thread, its weights, gradients and optimizer state are a contiguous block of the matrices of this layer.
+   *
+   * The forward pass gathers the outputs of the shards into the output of the layer, the backward pass sums the input
+   * gradients of the shards (each thread sums its part of the rows). All shards read the single input of the layer
+   * through views kept for the backward pass, there is no copy of the input per shard. The activation has to be
+   * element-wise.
+   */
+  class ShardedDenseLayer : public virtual ILayer {
+   public:
+    /**
+     * @throws std::invalid_argument if the activation is not element-wise or the shard count is not in [1, outputSize]
+     */
+    ShardedDenseLayer(size_t batchSize,
+        size_t inputSize,
+        size_t outputSize,
+        size_t shardCount,
+        std::unique_ptr<IActivationFunction>&& activationFunction,
+        IWeightInitializer& initializer);
+
+    ShardedDenseLayer(size_t inputSize,
+        size_t outputSize,
+        size_t shardCount,
+        std::unique_ptr<IActivationFunction>&& activationFunction,
+        IWeightInitializer& initializer);
+
+    std::unique_ptr<ILayer> Clone() const override;
+
+    const FloatMatrix& Forward(FloatMatrixView input) override;
+    const FloatMatrix& Backward(const FloatMatrix& gradient) override;
+    void Update(const FloatMatrix& weights, const FloatMatrix& biases) override;
+
+    inline size_t GetShardCount() const { return m_shards.size(); }
+
+    inline const FloatMatrix& GetWeights() const override { return m_weights; }
+    inline const FloatMatrix& GetBiases() const override { return m_biases; }
+    inline FloatMatrix& GetWeights() override { return m_weights; }
+    inline FloatMatrix& GetBiases() override { return m_biases; }
+    inline const FloatMatrix& GetWeightsGradient() const override { return m_gradientWeights; }
+    inline const FloatMatrix& GetBiasesGradient() const override { return m_gradientBias; }
+    inline FloatMatrix& GetWeightsVelocity() override { return m_weightVelocity; }
+    inline FloatMatrix& GetBiasesVelocity() override { return m_biasesVelocity; }
+    inline FloatMatrix& GetWeightsSecondMoment() override { return m_weightSecondMoment; }
+    inline FloatMatrix& GetBiasesSecondMoment() override { return m_biasesSecondMoment; }
+    void BindParameterStorage(const ParameterBuffers& weights, const ParameterBuffers& biases) override;
+
+   protected:
+    ShardedDenseLayer(const ShardedDenseLayer& other);
+
+   private:
+    /**
+     * @brief Moves the parameters into storage owned by the layer, until they are bound to an arena.
+     */
+    void BindOwnStorage();
+
+    size_t m_inputSize;
+    size_t m_outputSize;
+    std::vector<std::unique_ptr<ILayer>> m_shards;
+    // first output row of every shard, followed by the output size
+    std::vector<size_t> m_shardRows;
+    FloatMatrix::Storage m_ownStorage;
+
+    // The whole parameters of the layer, the shards work in blocks of rows of their storage.
+    FloatMatrix m_weights;
+    FloatMatrix m_biases;
+    FloatMatrix m_gradientWeights;
+    FloatMatrix m_gradientBias;
+    FloatMatrix m_weightVelocity;
+    FloatMatrix m_biasesVelocity;
+    FloatMatrix m_weightSecondMoment;
+    FloatMatrix m_biasesSecondMoment;
+
+    // Results of the passes and the rows of the output gradient for every shard, reused between batches.
+    FloatMatrix m_output;
+    FloatMatrix m_inputGradient;
+    std::vector<FloatMatrix> m_shardGradients;
+    std::vector<const FloatMatrix*> m_shardInputGradients;
+  };
+}  // namespace nnn
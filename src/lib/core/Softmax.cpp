@@ -28,9 +28,13 @@ static inline float SumExponentialsInColumn(nnn::FloatMatrix& matrix, size_t col
 
 namespace nnn {
 
-  void Softmax::Evaluate(FloatMatrix& input) const {  //
+  void Softmax::Evaluate(FloatMatrix& input) const {
+    EvaluateBlock(input, {0, input.GetRowCount(), 0, input.GetColCount()});
+  }
+
+  void Softmax::EvaluateBlock(FloatMatrix& input, const Gemm::Tile& block) const {  //
 
-    for (size_t col = 0; col < input.GetColCount(); ++col) {  //
+    for (size_t col = block.colBegin; col < block.colEnd; ++col) {  //
 
       float maxValueInColumn = FindMaxInColumn(input, col);
       float expSum = SumExponentialsInColumn(input, col, maxValueInColumn);
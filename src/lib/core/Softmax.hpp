@@ -8,6 +8,7 @@ namespace nnn {
   class Softmax : public IActivationFunction {
    public:
     Softmax() = default;
+    inline std::unique_ptr<IActivationFunction> Clone() const override { return std::make_unique<Softmax>(*this); }
 
     /**
      * @note Implementation inspired by https://www.aussieai.com/book/ch25-softmax-cpp-optimizations and
@@ -15,6 +16,12 @@ namespace nnn {
      */
     void Evaluate(FloatMatrix& input) const override;
 
+    /**
+     * @note The block has to span all rows (see `IsColumnWise()`), the softmax is computed per column.
+     */
+    void EvaluateBlock(FloatMatrix& input, const Gemm::Tile& block) const override;
+    inline bool IsColumnWise() const override { return true; }
+
     /**
      * @todo Not implemented yet.
      */
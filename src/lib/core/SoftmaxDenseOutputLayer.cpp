@@ -16,25 +16,37 @@ namespace nnn {
   SoftmaxDenseOutputLayer::SoftmaxDenseOutputLayer(size_t inputSize, size_t outputSize)
       : DenseLayer(inputSize, outputSize, std::make_unique<Softmax>()) {}
 
-  FloatMatrix SoftmaxDenseOutputLayer::ComputeOutputGradient(const FloatMatrix& actual, const FloatMatrix& expected) {
-    return m_crossEntropyLossFunction->Loss(actual, expected);
+  SoftmaxDenseOutputLayer::SoftmaxDenseOutputLayer(const SoftmaxDenseOutputLayer& other)
+      : DenseLayer(other), m_outputGradient(other.m_outputGradient) {}
+
+  std::unique_ptr<ILayer> SoftmaxDenseOutputLayer::Clone() const {
+    return std::unique_ptr<ILayer>(new SoftmaxDenseOutputLayer(*this));
   }
 
-  FloatMatrix SoftmaxDenseOutputLayer::Backward(const FloatMatrix& gradient) {  //
+  std::unique_ptr<IOutputLayer> SoftmaxDenseOutputLayer::CloneOutputLayer() const {
+    return std::unique_ptr<IOutputLayer>(new SoftmaxDenseOutputLayer(*this));
+  }
 
-    // Gradient here is already (actual - expected) from cross-entropy loss function.
-    // No need to call m_activationFunction->Derivative().
+  const FloatMatrix& SoftmaxDenseOutputLayer::ComputeOutputGradient(
+      const FloatMatrix& actual, LabelsView expected) {  //
 
-    auto hnc = gradient;
+    if (expected.HasClassIndices()) {
+      CrossEntropyWithSoftmax::LossInto(m_outputGradient, actual, expected.GetClassIndices());
+    } else {
+      m_crossEntropyLossFunction->LossInto(m_outputGradient, actual, expected.GetMatrix());
+    }
+    return m_outputGradient;
+  }
+
+  const FloatMatrix& SoftmaxDenseOutputLayer::Backward(const FloatMatrix& gradient) {  //
 
-    m_lastInput.Transpose();
-    m_gradientWeights = hnc * m_lastInput;
-    m_gradientBias = FloatMatrix::SumColumns(hnc);
+    // Gradient here is already (actual - expected) from cross-entropy loss function.
+    // No need to call m_activationFunction->Derivative().
 
-    hnc.Transpose();
-    auto nextGradient = hnc * m_weights;
-    nextGradient.Transpose();
+    FloatMatrix::MultiplyTransBInto(m_gradientWeights, gradient, m_lastInput);
+    FloatMatrix::SumColumnsInto(m_gradientBias, gradient);
 
-    return nextGradient;
+    FloatMatrix::MultiplyTransAInto(m_inputGradient, m_weights, gradient);
+    return m_inputGradient;
   }
 }  // namespace nnn
\ No newline at end of file
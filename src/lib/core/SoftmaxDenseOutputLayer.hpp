@@ -15,11 +15,18 @@ namespace nnn {
     SoftmaxDenseOutputLayer(size_t batchSize, size_t inputSize, size_t outputSize);
     SoftmaxDenseOutputLayer(size_t inputSize, size_t outputSize);
 
-    FloatMatrix ComputeOutputGradient(const FloatMatrix& actual, const FloatMatrix& expected) override;
+    std::unique_ptr<ILayer> Clone() const override;
+    std::unique_ptr<IOutputLayer> CloneOutputLayer() const override;
 
-    FloatMatrix Backward(const FloatMatrix& gradient) override;
+    const FloatMatrix& ComputeOutputGradient(const FloatMatrix& actual, LabelsView expected) override;
+
+    const FloatMatrix& Backward(const FloatMatrix& gradient) override;
+
+   protected:
+    SoftmaxDenseOutputLayer(const SoftmaxDenseOutputLayer& other);
 
    private:
     std::unique_ptr<ILossFunction> m_crossEntropyLossFunction = std::make_unique<CrossEntropyWithSoftmax>();
+    FloatMatrix m_outputGradient = FloatMatrix(0, 0);
   };
 }  // namespace nnn
@@ -2,14 +2,18 @@
 
 #include <iostream>
 #include <limits>
+#include <span>
 
 #include "FloatMatrixInvalidDimensionException.hpp"
 
 namespace nnn::TestDataSoftmaxEvaluator {
 
-  EvaluationResult Evaluate(const FloatMatrix& result, const FloatMatrix& testingLabels) {  //
+  EvaluationResult Evaluate(FloatMatrixView result, LabelsView testingLabels) {  //
 
-    if (result.GetColCount() != testingLabels.GetColCount() || result.GetRowCount() != testingLabels.GetRowCount()) {
+    const FloatMatrixView labels = testingLabels.GetMatrix();
+    const std::span<const ClassIndex> classIndices = testingLabels.GetClassIndices();
+    if (result.GetColCount() != testingLabels.GetSampleCount() ||
+        (!testingLabels.HasClassIndices() && result.GetRowCount() != labels.GetRowCount())) {
       throw FloatMatrixInvalidDimensionException("Dimensions of matrices for their evaluation have to be equal!");
     }
 
@@ -31,7 +35,9 @@ namespace nnn::TestDataSoftmaxEvaluator {
         }
       }
 
-      if (testingLabels(max_index, col) == 1.0f) {
+      const bool isCorrect = testingLabels.HasClassIndices() ? classIndices[col] == max_index
+                                                             : labels(max_index, col) == 1.0f;
+      if (isCorrect) {
         correctlyClassifiedCount++;
       }
     }
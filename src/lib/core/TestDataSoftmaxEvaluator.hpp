@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FloatMatrix.hpp"
+#include "LabelsView.hpp"
 
 namespace nnn::TestDataSoftmaxEvaluator {
 
@@ -11,5 +12,9 @@ namespace nnn::TestDataSoftmaxEvaluator {
     void Print() const;
   };
 
-  EvaluationResult Evaluate(const FloatMatrix& result, const FloatMatrix& testingLabels);
+  /**
+   * @brief Counts the samples whose most probable class is the labelled one, the labels are either one-hot encoded or
+   * class indices.
+   */
+  EvaluationResult Evaluate(FloatMatrixView result, LabelsView testingLabels);
 }  // namespace nnn::TestDataSoftmaxEvaluator
@@ -2,14 +2,40 @@
 
 #include <algorithm>
 #include <numeric>
+#include <span>
+#include <stdexcept>
 
 namespace nnn {
 
   TrainingDataset::TrainingDataset(
       std::shared_ptr<FloatMatrix> features, std::shared_ptr<FloatMatrix> labels, TrainingDatasetParameters params)
-      : m_features(features), m_labels(labels), m_params(params) {  //
+      : m_features(features), m_labels(labels), m_params(params) {
+    SplitDataset();
+  }
+
+  TrainingDataset::TrainingDataset(
+      std::shared_ptr<ByteMatrix> features, std::shared_ptr<FloatMatrix> labels, TrainingDatasetParameters params)
+      : m_compactFeatures(features), m_labels(labels), m_params(params) {
+    SplitDataset();
+  }
+
+  TrainingDataset::TrainingDataset(std::shared_ptr<FloatMatrix> features,
+      std::shared_ptr<std::vector<ClassIndex>> labels,
+      TrainingDatasetParameters params)
+      : m_features(features), m_classIndices(labels), m_params(params) {
+    SplitDataset();
+  }
+
+  TrainingDataset::TrainingDataset(std::shared_ptr<ByteMatrix> features,
+      std::shared_ptr<std::vector<ClassIndex>> labels,
+      TrainingDatasetParameters params)
+      : m_compactFeatures(features), m_classIndices(labels), m_params(params) {
+    SplitDataset();
+  }
+
+  void TrainingDataset::SplitDataset() {  //
 
-    int datasetSize = m_features->GetColCount();
+    int datasetSize = GetSampleCount();
     int batchSize = m_params.batchSize;
 
     int validationBatchCount = (m_params.validationSetFraction * datasetSize) / batchSize;
@@ -22,24 +48,58 @@ namespace nnn {
     m_trainingBatchCount = m_trainingDatasetSize / batchSize;
   }
 
-  FloatMatrix TrainingDataset::GetValidationFeatures() const {
-    return m_features->GetColumns(m_trainingDatasetSize, m_features->GetColCount() - 1);
+  const FloatMatrix& TrainingDataset::GetFloatFeatures() const {  //
+
+    if (m_features == nullptr) {
+      throw std::logic_error("The features of the dataset are compact, use GetFeatureColumns to convert them.");
+    }
+    return *m_features;
+  }
+
+  FloatMatrixView TrainingDataset::GetFeatureColumns(size_t begin, size_t end, FloatMatrix& buffer) const {  //
+
+    if (m_compactFeatures == nullptr) {
+      return m_features->ViewColumns(begin, end);
+    }
+    m_compactFeatures->ConvertColumnsInto(buffer, begin, end);
+    return buffer;
+  }
+
+  LabelsView TrainingDataset::GetLabelColumns(size_t begin, size_t end) const {  //
+
+    if (m_classIndices != nullptr) {
+      return std::span<const ClassIndex>(*m_classIndices).subspan(begin, end - begin + 1);
+    }
+    return m_labels->ViewColumns(begin, end);
+  }
+
+  FloatMatrixView TrainingDataset::GetValidationFeatures() const {
+    return GetFloatFeatures().ViewColumns(m_trainingDatasetSize, GetSampleCount() - 1);
   }
-  FloatMatrix TrainingDataset::GetValidationLabels() const {
-    return m_labels->GetColumns(m_trainingDatasetSize, m_labels->GetColCount() - 1);
+  LabelsView TrainingDataset::GetValidationLabels() const {
+    return GetLabelColumns(m_trainingDatasetSize, GetSampleCount() - 1);
   }
 
   bool TrainingDataset::HasValidationDataset() const { return m_params.validationSetFraction != 0.0f; }
 
-  FloatMatrix TrainingDataset::GetTrainingFeatures() const {
-    return m_features->GetColumns(0, m_trainingDatasetSize - 1);
+  FloatMatrixView TrainingDataset::GetTrainingFeatures() const {
+    return GetFloatFeatures().ViewColumns(0, m_trainingDatasetSize - 1);
   }
 
-  FloatMatrix TrainingDataset::GetTrainingLabels() const { return m_labels->GetColumns(0, m_trainingDatasetSize - 1); }
+  LabelsView TrainingDataset::GetTrainingLabels() const { return GetLabelColumns(0, m_trainingDatasetSize - 1); }
 
-  std::shared_ptr<const FloatMatrix> TrainingDataset::GetFeatures() const { return m_features; }
+  std::shared_ptr<const FloatMatrix> TrainingDataset::GetFeatures() const {
+    GetFloatFeatures();
+    return m_features;
+  }
+
+  std::shared_ptr<const FloatMatrix> TrainingDataset::GetLabels() const {  //
 
-  std::shared_ptr<const FloatMatrix> TrainingDataset::GetLabels() const { return m_labels; }
+    if (m_labels == nullptr) {
+      throw std::logic_error("The labels of the dataset are class indices, use the label views instead.");
+    }
+    return m_labels;
+  }
 
   // -----------------------------------------------------------------------------------------------------------
 
@@ -53,21 +113,43 @@ namespace nnn {
     }
   }
 
-  TrainingBatchGenerator::TrainingBatch TrainingBatchGenerator::GetNextBatch() {  //
+  TrainingBatchGenerator::TrainingBatch TrainingBatchGenerator::GetNextBatch() {
+    const size_t currentIndex = m_dataset.m_trainingBatchIndex++ % m_dataset.m_trainingBatchCount;
+    return GetBatch(currentIndex, m_featuresBuffer, m_labelsBuffer, m_classIndicesBuffer);
+  }
+
+  TrainingBatchGenerator::TrainingBatch TrainingBatchGenerator::GetBatch(size_t index,
+      FloatMatrix& featuresBuffer,
+      FloatMatrix& labelsBuffer,
+      std::vector<ClassIndex>& classIndicesBuffer) const {  //
 
-    int currentIndex = m_dataset.m_trainingBatchIndex++ % m_dataset.m_trainingBatchCount;
+    const size_t batchSize = m_dataset.m_params.batchSize;
+    const size_t begin = index * batchSize + m_params.shardIndex * batchSize / m_params.shardCount;
+    const size_t end = index * batchSize + (m_params.shardIndex + 1) * batchSize / m_params.shardCount;
     if (!m_params.isDataShufflingEnabled) {
-      return {m_dataset.m_features->GetColumns(
-                  currentIndex * m_dataset.m_params.batchSize, (currentIndex + 1) * m_dataset.m_params.batchSize - 1),
-          m_dataset.m_labels->GetColumns(
-              currentIndex * m_dataset.m_params.batchSize, (currentIndex + 1) * m_dataset.m_params.batchSize - 1)};
+      return {m_dataset.GetFeatureColumns(begin, end - 1, featuresBuffer), m_dataset.GetLabelColumns(begin, end - 1)};
     } else {
-      std::vector<size_t> subvector(m_indices.begin() + currentIndex * m_dataset.m_params.batchSize,
-          m_indices.begin() + (currentIndex + 1) * m_dataset.m_params.batchSize);
-      return {m_dataset.m_features->GetColumns(subvector), m_dataset.m_labels->GetColumns(subvector)};
+      // compact features are converted to floats while they are gathered
+      const std::span<const size_t> batchIndices(m_indices.data() + begin, end - begin);
+      if (m_dataset.m_compactFeatures != nullptr) {
+        m_dataset.m_compactFeatures->ConvertColumnsInto(featuresBuffer, batchIndices);
+      } else {
+        FloatMatrix::GatherColumnsInto(featuresBuffer, *m_dataset.m_features, batchIndices);
+      }
+      if (m_dataset.m_classIndices != nullptr) {
+        classIndicesBuffer.resize(batchIndices.size());
+        for (size_t i = 0; i < batchIndices.size(); ++i) {
+          classIndicesBuffer[i] = (*m_dataset.m_classIndices)[batchIndices[i]];
+        }
+        return {featuresBuffer, std::span<const ClassIndex>(classIndicesBuffer)};
+      }
+      FloatMatrix::GatherColumnsInto(labelsBuffer, *m_dataset.m_labels, batchIndices);
+      return {featuresBuffer, labelsBuffer};
     }
   }
 
+  size_t TrainingBatchGenerator::GetBatchCount() const { return m_dataset.m_trainingBatchCount; }
+
   bool TrainingBatchGenerator::HasNextBatch() const {
     return m_dataset.m_trainingBatchIndex < m_dataset.m_trainingBatchCount;
   }
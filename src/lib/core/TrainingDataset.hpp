@@ -2,8 +2,11 @@
 
 #include <memory>
 #include <random>
+#include <vector>
 
+#include "ByteMatrix.hpp"
 #include "FloatMatrix.hpp"
+#include "LabelsView.hpp"
 
 namespace nnn {
 
@@ -23,33 +26,83 @@ namespace nnn {
     TrainingDataset(
         std::shared_ptr<FloatMatrix> features, std::shared_ptr<FloatMatrix> labels, TrainingDatasetParameters params);
 
+    /**
+     * @brief Dataset with compact features (a byte per value), converted to floats only when the batches are gathered
+     * (see `GetFeatureColumns`). The float views of the features are not available.
+     */
+    TrainingDataset(
+        std::shared_ptr<ByteMatrix> features, std::shared_ptr<FloatMatrix> labels, TrainingDatasetParameters params);
+
+    /**
+     * @brief Datasets with the class index of every sample as labels instead of a (one-hot encoded) matrix, the label
+     * views and batches are class indices then.
+     */
+    TrainingDataset(std::shared_ptr<FloatMatrix> features,
+        std::shared_ptr<std::vector<ClassIndex>> labels,
+        TrainingDatasetParameters params);
+    TrainingDataset(std::shared_ptr<ByteMatrix> features,
+        std::shared_ptr<std::vector<ClassIndex>> labels,
+        TrainingDatasetParameters params);
+
+    inline bool HasCompactFeatures() const { return m_compactFeatures != nullptr; }
+    inline bool HasClassIndices() const { return m_classIndices != nullptr; }
+    inline size_t GetSampleCount() const {
+      return m_classIndices != nullptr ? m_classIndices->size() : m_labels->GetColCount();
+    }
+    inline size_t GetTrainingSampleCount() const { return m_trainingDatasetSize; }
+
+    /**
+     * @brief Features of samples [begin, end] as floats: a view of the dataset, or (for compact features) the values
+     * converted into the buffer.
+     */
+    FloatMatrixView GetFeatureColumns(size_t begin, size_t end, FloatMatrix& buffer) const;
+
+    /**
+     * @throws std::logic_error if the features are compact
+     */
     std::shared_ptr<const FloatMatrix> GetFeatures() const;
+
+    /**
+     * @throws std::logic_error if the labels are class indices
+     */
     std::shared_ptr<const FloatMatrix> GetLabels() const;
 
-    FloatMatrix GetTrainingFeatures() const;
-    FloatMatrix GetTrainingLabels() const;
+    // The subsets are views of the whole dataset, they stay valid as long as the dataset does. The features throw
+    // std::logic_error if they are compact.
+
+    FloatMatrixView GetTrainingFeatures() const;
+    LabelsView GetTrainingLabels() const;
 
-    FloatMatrix GetValidationFeatures() const;
-    FloatMatrix GetValidationLabels() const;
+    FloatMatrixView GetValidationFeatures() const;
+    LabelsView GetValidationLabels() const;
     bool HasValidationDataset() const;
+    inline size_t GetBatchSize() const { return m_params.batchSize; }
 
     friend class TrainingBatchGenerator;
 
    private:
+    // exactly one of the feature matrices and one of the labels are set
     std::shared_ptr<const FloatMatrix> m_features;
+    std::shared_ptr<const ByteMatrix> m_compactFeatures;
     std::shared_ptr<const FloatMatrix> m_labels;
+    std::shared_ptr<const std::vector<ClassIndex>> m_classIndices;
     TrainingDatasetParameters m_params;
     size_t m_validationDatasetSize = 0;
     size_t m_trainingDatasetSize = 0;
     size_t m_trainingBatchCount = 0;
     size_t m_trainingBatchIndex = 0;
+
+    void SplitDataset();
+    const FloatMatrix& GetFloatFeatures() const;
+    LabelsView GetLabelColumns(size_t begin, size_t end) const;
   };
 
   // TODO: this could be better done using ITrainingBatchGenerator or something, where we would have concrete
   // implementation with shuffling and implementation without.
   /**
    * @brief Generator class for yielding batches. Data are shuffled when you initialize the generator or call Reset()
-   * method.
+   * method. Batches of unshuffled data are views of the dataset, shuffled batches are gathered into buffers owned by
+   * the generator, which are reused, so a batch is only valid until the next call of GetNextBatch().
    *
    * @warning The behaviour is non-deterministic as the standard does not mandate the exact shuffling
    * algorithm  or the exact number of random values it consumes from the engine for a given shuffle operation.
@@ -59,16 +112,31 @@ namespace nnn {
     struct TrainingBatchGeneratorParameters {
       bool isDataShufflingEnabled = false;
       int seed = 42;
+      // every batch is split into `shardCount` parts and only the part `shardIndex` is returned (multi-process
+      // training)
+      size_t shardIndex = 0;
+      size_t shardCount = 1;
     };
 
     struct TrainingBatch {
-      FloatMatrix features;
-      FloatMatrix labels;
+      FloatMatrixView features;
+      LabelsView labels;
     };
 
     TrainingBatchGenerator(TrainingDataset& dataset, TrainingBatchGeneratorParameters params);
 
     TrainingBatch GetNextBatch();
+
+    /**
+     * @brief Random access to the batches of the current epoch (in the current shuffled order), safe to call from
+     * several threads at once: shuffled batches are gathered into the given buffers instead of the generator's own
+     * (the labels into the matrix or the class indices, depending on the dataset).
+     */
+    TrainingBatch GetBatch(size_t index,
+        FloatMatrix& featuresBuffer,
+        FloatMatrix& labelsBuffer,
+        std::vector<ClassIndex>& classIndicesBuffer) const;
+    size_t GetBatchCount() const;
     bool HasNextBatch() const;
     void Reset();
     const std::vector<size_t>& GetIndices() const;
@@ -77,6 +145,9 @@ namespace nnn {
     TrainingDataset& m_dataset;
     TrainingBatchGeneratorParameters m_params;
     std::vector<size_t> m_indices;
+    FloatMatrix m_featuresBuffer = FloatMatrix(0, 0);
+    FloatMatrix m_labelsBuffer = FloatMatrix(0, 0);
+    std::vector<ClassIndex> m_classIndicesBuffer;
     std::mt19937 m_generator;
   };
 }  // namespace nnn
@@ -2,7 +2,16 @@
 #include <catch2/matchers/catch_matchers.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
 #include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <vector>
 
 #include <iostream>
 
@@ -11,19 +20,28 @@
 #include <omp.h>
 #endif
 
+#include "AdamOptimizer.hpp"
+#include "ByteMatrix.hpp"
 #include "CrossEntropyWithSoftmax.hpp"
 #include "CSVReader.hpp"
 #include "DataLoader.hpp"
 #include "DenseLayer.hpp"
 #include "FloatMatrix.hpp"
+#include "FloatMatrixInvalidDimensionException.hpp"
 #include "ILayer.hpp"
+#include "LabelsView.hpp"
 #include "LeakyReLU.hpp"
+#include "MatrixExpression.hpp"
 #include "NeuralNetwork.hpp"
 #include "NormalGlorotWeightInitializer.hpp"
 #include "NormalHeWeightInitializer.hpp"
+#include "ProcessGroup.hpp"
 #include "ReLU.hpp"
+#include "RMSPropOptimizer.hpp"
+#include "ShardedDenseLayer.hpp"
 #include "Softmax.hpp"
 #include "SoftmaxDenseOutputLayer.hpp"
+#include "TestDataSoftmaxEvaluator.hpp"
 #include "TrainingDataset.hpp"
 
 #include "TestableNeuralNetwork.hpp"
@@ -44,7 +62,100 @@ static inline LayerType* GetLayerAs(nnn::NeuralNetwork* neuralNetwork, size_t in
   return dynamic_cast<LayerType*>(baseLayer);
 }
 
-// // ------------------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------------------
+
+// Counting allocator hook: the global allocation functions are replaced for this test executable, every allocation is
+// counted while `isCountingAllocations` is set. All the variants (array, aligned, nothrow) are replaced, so that every
+// block is freed by the same allocator which allocated it.
+
+static std::atomic<bool> isCountingAllocations = false;
+static std::atomic<size_t> allocationCount = 0;
+
+static void* CountedAllocate(size_t size, size_t alignment) {  //
+
+  if (isCountingAllocations) {
+    ++allocationCount;
+  }
+
+  // the original pointer is stored right before the aligned block, so that the memory can be freed
+  void* raw = std::malloc(size + alignment + sizeof(void*));
+  if (raw == nullptr) {
+    throw std::bad_alloc();
+  }
+  const uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~(alignment - 1);
+  reinterpret_cast<void**>(aligned)[-1] = raw;
+  return reinterpret_cast<void*>(aligned);
+}
+
+static void CountedFree(void* ptr) noexcept {
+  if (ptr != nullptr) {
+    std::free(static_cast<void**>(ptr)[-1]);
+  }
+}
+
+static void* CountedAllocateNoThrow(size_t size, size_t alignment) noexcept {
+  try {
+    return CountedAllocate(size, alignment);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new(size_t size) { return CountedAllocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return CountedAllocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) {
+  return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return CountedAllocate(size, static_cast<size_t>(alignment));
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocateNoThrow(size, alignof(std::max_align_t));
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocateNoThrow(size, alignof(std::max_align_t));
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return CountedAllocateNoThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return CountedAllocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+
+// One-hot labels of `sampleCount` samples cycling through the classes 0, 1, ..., classCount - 1.
+static nnn::FloatMatrix CreateCyclicLabels(size_t classCount, size_t sampleCount) {
+  auto labels = nnn::FloatMatrix::Zeroes(classCount, sampleCount);
+  for (size_t col = 0; col < sampleCount; ++col) {
+    labels(col % classCount, col) = 1.0f;
+  }
+  return labels;
+}
+
+// For results of the same training computed in a different order (e.g. gradients summed by several replicas).
+static void CheckNearlyEqual(const nnn::FloatMatrix& actual, const nnn::FloatMatrix& expected, float margin = 1e-5f) {
+  REQUIRE(actual.GetRowCount() == expected.GetRowCount());
+  REQUIRE(actual.GetColCount() == expected.GetColCount());
+  for (size_t row = 0; row < expected.GetRowCount(); ++row) {
+    for (size_t col = 0; col < expected.GetColCount(); ++col) {
+      CHECK_THAT(actual(row, col), Catch::Matchers::WithinAbs(expected(row, col), margin));
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------------------
 
 TEST_CASE("Initialization") {
 #ifdef _OPENMP
@@ -294,6 +405,41 @@ TEST_CASE("2 Layer NN - Basic forward and backward pass with ReLU and SoftMax")
   }
 }
 
+TEST_CASE("Dense layers - Fused forward pass matches separate steps") {  //
+
+  // Sizes are chosen so that the output is split into multiple blocks of the matrix multiplication.
+  const size_t inputSize = 300;
+  const size_t outputSize = 200;
+  const size_t batchSize = 70;
+
+  auto weights = nnn::FloatMatrix::Random(outputSize, inputSize, -0.1f, 0.1f);
+  auto biases = nnn::FloatMatrix::Random(outputSize, 1, -1.0f, 1.0f);
+  auto input = nnn::FloatMatrix::Random(inputSize, batchSize, -1.0f, 1.0f);
+
+  auto expectedPotential = weights * input;
+  expectedPotential.AddToAllCols(biases);
+
+  {
+    nnn::DenseLayer layer(batchSize, inputSize, outputSize, std::make_unique<nnn::LeakyReLU>());
+    layer.Update(weights, biases);
+    auto result = layer.Forward(input);
+
+    auto expected = expectedPotential;
+    nnn::LeakyReLU().Evaluate(expected);
+    CHECK(result == expected);
+  }
+
+  {
+    nnn::SoftmaxDenseOutputLayer layer(batchSize, inputSize, outputSize);
+    layer.Update(weights, biases);
+    auto result = layer.Forward(input);
+
+    auto expected = expectedPotential;
+    nnn::Softmax().Evaluate(expected);
+    CHECK(result == expected);
+  }
+}
+
 // TEST_CASE("3 Layer NN - Solve XOR as a decision problem with ReLU and Softmax") {  //
 //
 //   // intentionally testing overfitting
@@ -465,10 +611,10 @@ TEST_CASE("TrainingDataset - Shuffling") {
   CHECK(batch1.features(0, 1) == 3.0f);
   CHECK(batch1.features(1, 0) == 6.0f);
   CHECK(batch1.features(1, 1) == 7.0f);
-  CHECK(batch1.labels(0, 0) == -2.0f);
-  CHECK(batch1.labels(0, 1) == -3.0f);
-  CHECK(batch1.labels(1, 0) == -6.0f);
-  CHECK(batch1.labels(1, 1) == -7.0f);
+  CHECK(batch1.labels.GetMatrix()(0, 0) == -2.0f);
+  CHECK(batch1.labels.GetMatrix()(0, 1) == -3.0f);
+  CHECK(batch1.labels.GetMatrix()(1, 0) == -6.0f);
+  CHECK(batch1.labels.GetMatrix()(1, 1) == -7.0f);
 #else
 #endif
 
@@ -478,10 +624,10 @@ TEST_CASE("TrainingDataset - Shuffling") {
   CHECK(batch2.features(0, 1) == 1.0f);
   CHECK(batch2.features(1, 0) == 4.0f);
   CHECK(batch2.features(1, 1) == 5.0f);
-  CHECK(batch2.labels(0, 0) == 0.0f);
-  CHECK(batch2.labels(0, 1) == -1.0f);
-  CHECK(batch2.labels(1, 0) == -4.0f);
-  CHECK(batch2.labels(1, 1) == -5.0f);
+  CHECK(batch2.labels.GetMatrix()(0, 0) == 0.0f);
+  CHECK(batch2.labels.GetMatrix()(0, 1) == -1.0f);
+  CHECK(batch2.labels.GetMatrix()(1, 0) == -4.0f);
+  CHECK(batch2.labels.GetMatrix()(1, 1) == -5.0f);
 #else
 #endif
 
@@ -496,3 +642,672 @@ TEST_CASE("TrainingDataset - Shuffling") {
 #else
 #endif
 }
+
+TEST_CASE("TrainingDataset - Subsets and batches are views of the dataset") {
+  auto features = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Random(3, 10));
+  auto labels = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Random(2, 10));
+
+  auto dataset = nnn::TrainingDataset(features, labels, {.batchSize = 2, .validationSetFraction = 0.4f});
+
+  nnn::FloatMatrixView trainingFeatures = dataset.GetTrainingFeatures();
+  nnn::FloatMatrixView validationLabels = dataset.GetValidationLabels().GetMatrix();
+  CHECK(trainingFeatures.GetColCount() == 6);
+  CHECK(validationLabels.GetColCount() == 4);
+  CHECK(&trainingFeatures(2, 5) == &(*features)(2, 5));
+  CHECK(&validationLabels(1, 0) == &(*labels)(1, 6));
+
+  auto generator = nnn::TrainingBatchGenerator(dataset, {.isDataShufflingEnabled = false});
+  auto batch = generator.GetNextBatch();
+  batch = generator.GetNextBatch();
+  CHECK(batch.features.GetColCount() == 2);
+  CHECK(&batch.features(0, 0) == &(*features)(0, 2));
+  CHECK(&batch.labels.GetMatrix()(1, 1) == &(*labels)(1, 3));
+}
+
+TEST_CASE("TrainingDataset - Compact features are normalized while gathered") {  //
+
+  // more samples than a prediction chunk of compact features
+  const size_t sampleCount = 5000;
+  std::vector<uint8_t> bytes(3 * sampleCount);
+  // column-major like the features read by the DataLoader
+  auto features = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Zeroes(sampleCount, 3));
+  features->Transpose();
+  auto labels = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Zeroes(2, sampleCount));
+  for (size_t col = 0; col < sampleCount; ++col) {
+    for (size_t row = 0; row < 3; ++row) {
+      bytes[col * 3 + row] = static_cast<uint8_t>((col * 7 + row * 31) % 256);
+      (*features)(row, col) = bytes[col * 3 + row] / 256.0f;
+    }
+    (*labels)(col % 2, col) = 1.0f;
+  }
+  auto compactFeatures = std::make_shared<nnn::ByteMatrix>(3, sampleCount, std::move(bytes), 1.0f / 256.0f);
+
+  auto dataset = nnn::TrainingDataset(features, labels, {.batchSize = 50, .validationSetFraction = 0.2f});
+  auto compactDataset = nnn::TrainingDataset(compactFeatures, labels, {.batchSize = 50, .validationSetFraction = 0.2f});
+  REQUIRE(compactDataset.HasCompactFeatures());
+  REQUIRE(compactDataset.GetTrainingSampleCount() == dataset.GetTrainingSampleCount());
+  REQUIRE_THROWS_AS(compactDataset.GetTrainingFeatures(), std::logic_error);
+
+  // the conversion is exact for a power of two
+  for (bool isShuffled : {false, true}) {
+    auto generator = nnn::TrainingBatchGenerator(dataset, {.isDataShufflingEnabled = isShuffled, .seed = 3});
+    auto compactGenerator =
+        nnn::TrainingBatchGenerator(compactDataset, {.isDataShufflingEnabled = isShuffled, .seed = 3});
+    for (int step = 0; step < 3; ++step) {
+      auto batch = generator.GetNextBatch();
+      auto compactBatch = compactGenerator.GetNextBatch();
+      CHECK(nnn::FloatMatrix(compactBatch.features) == nnn::FloatMatrix(batch.features));
+      CHECK(nnn::FloatMatrix(compactBatch.labels.GetMatrix()) == nnn::FloatMatrix(batch.labels.GetMatrix()));
+    }
+  }
+
+  nnn::NormalHeWeightInitializer initializer(29);
+  auto network = nnn::NeuralNetwork();
+  network.AddHiddenLayer(std::make_unique<nnn::DenseLayer>(3, 4, std::make_unique<nnn::ReLU>(), initializer));
+  network.SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(4, 2, initializer));
+
+  const nnn::FloatMatrix expected = network.Predict(dataset, 0, sampleCount - 1);
+  const nnn::FloatMatrix actual = network.Predict(compactDataset, 0, sampleCount - 1);
+  REQUIRE(actual.GetRowCount() == 2);
+  REQUIRE(actual.GetColCount() == sampleCount);
+  for (size_t col = 0; col < sampleCount; col += 7) {
+    CHECK_THAT(actual(0, col), Catch::Matchers::WithinAbs(expected(0, col), 1e-6f));
+    CHECK_THAT(actual(1, col), Catch::Matchers::WithinAbs(expected(1, col), 1e-6f));
+  }
+}
+
+TEST_CASE("NeuralNetwork - Class index labels train like one-hot labels") {  //
+
+  const size_t sampleCount = 120;
+  auto features = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Random(4, sampleCount, -1.0f, 1.0f));
+  auto labels = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Zeroes(3, sampleCount));
+  auto classIndices = std::make_shared<std::vector<nnn::ClassIndex>>(sampleCount);
+  for (size_t col = 0; col < sampleCount; ++col) {
+    const size_t label = (*features)(0, col) > 0.5f ? 2 : ((*features)(1, col) > 0.0f ? 1 : 0);
+    (*labels)(label, col) = 1.0f;
+    (*classIndices)[col] = static_cast<nnn::ClassIndex>(label);
+  }
+
+  auto dataset = nnn::TrainingDataset(features, labels, {.batchSize = 10, .validationSetFraction = 0.25f});
+  auto indexDataset = nnn::TrainingDataset(features, classIndices, {.batchSize = 10, .validationSetFraction = 0.25f});
+  REQUIRE(indexDataset.HasClassIndices());
+  REQUIRE(indexDataset.GetTrainingLabels().GetSampleCount() == dataset.GetTrainingLabels().GetSampleCount());
+  REQUIRE_THROWS_AS(indexDataset.GetLabels(), std::logic_error);
+
+  // shuffled batches gather the same samples
+  auto generator = nnn::TrainingBatchGenerator(dataset, {.isDataShufflingEnabled = true, .seed = 5});
+  auto indexGenerator = nnn::TrainingBatchGenerator(indexDataset, {.isDataShufflingEnabled = true, .seed = 5});
+  auto batch = generator.GetNextBatch();
+  auto indexBatch = indexGenerator.GetNextBatch();
+  REQUIRE(indexBatch.labels.HasClassIndices());
+  REQUIRE(indexBatch.labels.GetSampleCount() == 10);
+  for (size_t col = 0; col < 10; ++col) {
+    CHECK(batch.labels.GetMatrix()(indexBatch.labels.GetClassIndices()[col], col) == 1.0f);
+  }
+
+  // two replicas, so that the labels are split between them as well
+  auto train = [](nnn::TrainingDataset& trainingDataset) {
+    nnn::NormalHeWeightInitializer initializer(17);
+    auto network = std::make_unique<nnn::NeuralNetwork>(nnn::NeuralNetwork::HyperParameters{
+        .learningRate = 0.05f, .momentum = 0.9f, .epochs = 3, .dataParallelReplicas = 2});
+    network->AddHiddenLayer(std::make_unique<nnn::DenseLayer>(4, 6, std::make_unique<nnn::LeakyReLU>(), initializer));
+    network->SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(6, 3, initializer));
+    auto statistics = network->Train(trainingDataset);
+    return std::make_pair(std::move(network), statistics);
+  };
+
+  auto [network, statistics] = train(dataset);
+  auto [indexNetwork, indexStatistics] = train(indexDataset);
+
+  REQUIRE(indexStatistics.trainingLosses.size() == statistics.trainingLosses.size());
+  for (size_t epoch = 0; epoch < statistics.trainingLosses.size(); ++epoch) {
+    CHECK_THAT(
+        indexStatistics.trainingLosses[epoch], Catch::Matchers::WithinAbs(statistics.trainingLosses[epoch], 1e-4f));
+  }
+  for (size_t index = 0; index < 2; ++index) {
+    CHECK(indexNetwork->GetLayer(index)->GetWeights() == network->GetLayer(index)->GetWeights());
+  }
+
+  const nnn::FloatMatrix predictions = network->RunForwardPass(dataset.GetValidationFeatures());
+  auto evaluation = nnn::TestDataSoftmaxEvaluator::Evaluate(predictions, dataset.GetValidationLabels());
+  auto indexEvaluation = nnn::TestDataSoftmaxEvaluator::Evaluate(predictions, indexDataset.GetValidationLabels());
+  CHECK(indexEvaluation.totalExamplesCount == evaluation.totalExamplesCount);
+  CHECK(indexEvaluation.correctlyClassifiedCount == evaluation.correctlyClassifiedCount);
+
+  // a class index outside of the output
+  std::vector<nnn::ClassIndex> wrongClassIndices(10, 3);
+  REQUIRE_THROWS_AS(
+      network->RunTrainingStep(features->ViewColumns(0, 9), std::span<const nnn::ClassIndex>(wrongClassIndices)),
+      std::out_of_range);
+}
+
+TEST_CASE("NeuralNetwork - Training step does not allocate once warmed up") {  //
+
+  const size_t batchSize = 16;
+  auto features = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Random(20, 128, -1.0f, 1.0f));
+  auto labels = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Zeroes(4, 128));
+  for (size_t col = 0; col < labels->GetColCount(); ++col) {
+    (*labels)(col % 4, col) = 1.0f;
+  }
+
+  auto dataset = nnn::TrainingDataset(features, labels, {.batchSize = batchSize, .validationSetFraction = 0.0f});
+  auto generator = nnn::TrainingBatchGenerator(dataset, {.isDataShufflingEnabled = true, .seed = 7});
+
+  nnn::NormalHeWeightInitializer initializer(7);
+  auto neuralNetwork = nnn::NeuralNetwork({.learningRate = 0.01f, .weightDecay = 0.001f, .momentum = 0.9f});
+  neuralNetwork.AddHiddenLayer(
+      std::make_unique<nnn::DenseLayer>(batchSize, 20, 32, std::make_unique<nnn::LeakyReLU>(0.01f), initializer));
+  neuralNetwork.AddHiddenLayer(
+      std::make_unique<nnn::DenseLayer>(batchSize, 32, 16, std::make_unique<nnn::LeakyReLU>(0.01f), initializer));
+  neuralNetwork.SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(batchSize, 16, 4, initializer));
+
+  // the first step sizes the buffers that are not known in advance (e.g. the output gradient)
+  auto batch = generator.GetNextBatch();
+  neuralNetwork.RunTrainingStep(batch.features, batch.labels);
+
+  allocationCount = 0;
+  isCountingAllocations = true;
+  size_t steps = 0;
+  for (int epoch = 0; epoch < 2; ++epoch) {
+    while (generator.HasNextBatch()) {
+      batch = generator.GetNextBatch();
+      neuralNetwork.RunTrainingStep(batch.features, batch.labels);
+      ++steps;
+    }
+    generator.Reset();
+  }
+  isCountingAllocations = false;
+
+  CHECK(steps > 10);
+  CHECK(allocationCount == 0);
+}
+
+TEST_CASE("NeuralNetwork - Fused weight update matches the momentum and weight decay formulas") {  //
+
+  const size_t batchSize = 8;
+  const nnn::NeuralNetwork::HyperParameters params = {.learningRate = 0.035f, .weightDecay = 0.002f, .momentum = 0.9f};
+
+  nnn::NormalHeWeightInitializer initializer(3);
+  auto network = nnn::NeuralNetwork(params);
+  network.AddHiddenLayer(
+      std::make_unique<nnn::DenseLayer>(batchSize, 6, 5, std::make_unique<nnn::LeakyReLU>(0.01f), initializer));
+  network.SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(batchSize, 5, 3, initializer));
+
+  auto features = nnn::FloatMatrix::Random(6, batchSize, -1.0f, 1.0f);
+  auto labels = CreateCyclicLabels(3, batchSize);
+
+  // a few steps first, so that the velocities are not zero
+  for (int step = 0; step < 3; ++step) {
+    network.RunTrainingStep(features, labels);
+  }
+
+  struct Snapshot {
+    nnn::FloatMatrix weights, biases, weightVelocity, biasVelocity;
+  };
+
+  std::vector<Snapshot> expected;
+  for (size_t index = 0; index < 2; ++index) {
+    nnn::ILayer& layer = *network.GetLayer(index);
+    nnn::FloatMatrix weightVelocity = nnn::Lazy(layer.GetWeightsVelocity()) * params.momentum +
+                                      layer.GetWeightsGradient();
+    nnn::FloatMatrix biasVelocity = nnn::Lazy(layer.GetBiasesVelocity()) * params.momentum + layer.GetBiasesGradient();
+    nnn::FloatMatrix weights = nnn::Lazy(layer.GetWeights()) * (1 - params.learningRate * params.weightDecay) -
+                               nnn::Lazy(weightVelocity) * params.learningRate;
+    nnn::FloatMatrix biases = layer.GetBiases() - nnn::Lazy(biasVelocity) * params.learningRate;
+    expected.push_back({weights, biases, weightVelocity, biasVelocity});
+  }
+
+  network.UpdateWeights();
+
+  // bit-for-bit, the update has to follow exactly the same arithmetic
+  auto isIdentical = [](const nnn::FloatMatrix& a, const nnn::FloatMatrix& b) {
+    if (a.GetRowCount() != b.GetRowCount() || a.GetColCount() != b.GetColCount()) {
+      return false;
+    }
+    for (size_t row = 0; row < a.GetRowCount(); ++row) {
+      for (size_t col = 0; col < a.GetColCount(); ++col) {
+        if (a(row, col) != b(row, col)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  for (size_t index = 0; index < 2; ++index) {
+    nnn::ILayer& layer = *network.GetLayer(index);
+    CHECK(isIdentical(layer.GetWeights(), expected[index].weights));
+    CHECK(isIdentical(layer.GetBiases(), expected[index].biases));
+    CHECK(isIdentical(layer.GetWeightsVelocity(), expected[index].weightVelocity));
+    CHECK(isIdentical(layer.GetBiasesVelocity(), expected[index].biasVelocity));
+  }
+}
+
+TEST_CASE("NeuralNetwork - Parameters of all layers live in one arena") {  //
+
+  const size_t batchSize = 4;
+  nnn::NormalHeWeightInitializer initializer(7);
+  auto network = nnn::NeuralNetwork({.learningRate = 0.01f, .weightDecay = 0.0f, .momentum = 0.9f});
+  network.AddHiddenLayer(
+      std::make_unique<nnn::DenseLayer>(batchSize, 6, 5, std::make_unique<nnn::ReLU>(), initializer));
+  network.SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(batchSize, 5, 3, initializer));
+
+  const nnn::FloatMatrix initialWeights = network.GetLayer(1)->GetWeights();
+  CHECK(!network.GetParameterArena().IsBound());
+
+  auto features = nnn::FloatMatrix::Random(6, batchSize, -1.0f, 1.0f);
+  auto labels = CreateCyclicLabels(3, batchSize);
+  network.RunBackwardPass(nnn::CrossEntropyWithSoftmax().Loss(network.RunForwardPass(features), labels));
+
+  // the gradients are moved into the arena too, with the values of the backward pass
+  const nnn::FloatMatrix gradient = network.GetLayer(1)->GetWeightsGradient();
+  network.UpdateWeights();
+
+  const nnn::ParameterArena& arena = network.GetParameterArena();
+  REQUIRE(arena.IsBound());
+  CHECK(arena.GetWeightCount() == 6 * 5 + 5 * 3);
+  CHECK(arena.GetBiasCount() == 5 + 3);
+
+  // all weights first, layer by layer, then all biases
+  const float* parameters = arena.GetParameters();
+  CHECK(network.GetLayer(0)->GetWeights().Data() == parameters);
+  CHECK(network.GetLayer(1)->GetWeights().Data() == parameters + 30);
+  CHECK(network.GetLayer(0)->GetBiases().Data() == parameters + 45);
+  CHECK(network.GetLayer(1)->GetBiases().Data() == parameters + 50);
+  CHECK(network.GetLayer(1)->GetWeightsGradient().Data() == arena.GetGradients() + 30);
+  CHECK(network.GetLayer(1)->GetWeightsGradient() == gradient);
+
+  // the first step of momentum SGD from zero velocity is a plain gradient step
+  for (size_t row = 0; row < 3; ++row) {
+    for (size_t col = 0; col < 5; ++col) {
+      CHECK(parameters[30 + row * 5 + col] == initialWeights(row, col) - gradient(row, col) * 0.01f);
+    }
+  }
+
+  // adding a layer rebinds the arena on the next update, keeping the trained values
+  const nnn::FloatMatrix trainedWeights = network.GetLayer(0)->GetWeights();
+  network.AddHiddenLayer(
+      std::make_unique<nnn::DenseLayer>(batchSize, 5, 5, std::make_unique<nnn::ReLU>(), initializer));
+  CHECK(!network.GetParameterArena().IsBound());
+  network.UpdateWeights();
+  CHECK(network.GetParameterArena().GetWeightCount() == 6 * 5 + 5 * 3 + 5 * 5);
+  CHECK(network.GetLayer(0)->GetWeights().Data() == network.GetParameterArena().GetParameters());
+}
+
+TEST_CASE("NeuralNetwork - Data-parallel replicas match single-replica training") {  //
+
+  const size_t batchSize = 30;
+  auto createNetwork = [](size_t replicas) {
+    nnn::NormalHeWeightInitializer initializer(11);
+    auto network = std::make_unique<nnn::NeuralNetwork>(nnn::NeuralNetwork::HyperParameters{
+        .learningRate = 0.05f, .weightDecay = 0.01f, .momentum = 0.9f, .dataParallelReplicas = replicas});
+    network->AddHiddenLayer(std::make_unique<nnn::DenseLayer>(8, 7, std::make_unique<nnn::LeakyReLU>(), initializer));
+    network->SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(7, 3, initializer));
+    return network;
+  };
+
+  auto single = createNetwork(1);
+  auto parallel = createNetwork(4);
+
+  auto features = nnn::FloatMatrix::Random(8, batchSize, -1.0f, 1.0f);
+  auto labels = CreateCyclicLabels(3, batchSize);
+
+  // uneven shares (30 columns between 4 replicas) and a last batch smaller than the number of replicas
+  for (int step = 0; step < 5; ++step) {
+    single->RunTrainingStep(features, labels);
+    parallel->RunTrainingStep(features, labels);
+  }
+  single->RunTrainingStep(features.ViewColumns(0, 1), labels.ViewColumns(0, 1));
+  parallel->RunTrainingStep(features.ViewColumns(0, 1), labels.ViewColumns(0, 1));
+
+  // the gradients are summed in a different order, so only nearly equal
+  for (size_t index = 0; index < 2; ++index) {
+    CheckNearlyEqual(parallel->GetLayer(index)->GetWeights(), single->GetLayer(index)->GetWeights());
+    CheckNearlyEqual(parallel->GetLayer(index)->GetBiases(), single->GetLayer(index)->GetBiases());
+  }
+}
+
+TEST_CASE("NeuralNetwork - Pipelined training matches unpipelined training") {  //
+
+  const size_t batchSize = 30;
+  auto createNetwork = [](size_t microBatches) {
+    nnn::NormalHeWeightInitializer initializer(17);
+    auto network = std::make_unique<nnn::NeuralNetwork>(nnn::NeuralNetwork::HyperParameters{
+        .learningRate = 0.05f, .weightDecay = 0.01f, .momentum = 0.9f, .pipelineMicroBatches = microBatches});
+    network->AddHiddenLayer(std::make_unique<nnn::DenseLayer>(8, 7, std::make_unique<nnn::LeakyReLU>(), initializer));
+    network->AddHiddenLayer(std::make_unique<nnn::DenseLayer>(7, 5, std::make_unique<nnn::ReLU>(), initializer));
+    network->SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(5, 3, initializer));
+    return network;
+  };
+
+  auto single = createNetwork(1);
+  auto pipelined = createNetwork(4);
+
+  auto features = nnn::FloatMatrix::Random(8, batchSize, -1.0f, 1.0f);
+  auto labels = CreateCyclicLabels(3, batchSize);
+
+  // uneven micro-batches (30 columns in 4) and a last batch smaller than the number of micro-batches
+  for (int step = 0; step < 5; ++step) {
+    single->RunTrainingStep(features, labels);
+    pipelined->RunTrainingStep(features, labels);
+  }
+  single->RunTrainingStep(features.ViewColumns(0, 2), labels.ViewColumns(0, 2));
+  pipelined->RunTrainingStep(features.ViewColumns(0, 2), labels.ViewColumns(0, 2));
+
+  for (size_t index = 0; index < 3; ++index) {
+    CheckNearlyEqual(pipelined->GetLayer(index)->GetWeights(), single->GetLayer(index)->GetWeights());
+    CheckNearlyEqual(pipelined->GetLayer(index)->GetBiases(), single->GetLayer(index)->GetBiases());
+  }
+
+#ifdef _OPENMP
+  // nested in another parallel region the pipeline gets a single thread and has to run its stages one by one
+  auto nested = createNetwork(4);
+  auto reference = createNetwork(1);
+  for (int step = 0; step < 3; ++step) {
+    reference->RunTrainingStep(features, labels);
+#pragma omp parallel num_threads(2)
+    {
+      if (omp_get_thread_num() == 0) {
+        nested->RunTrainingStep(features, labels);
+      }
+    }
+  }
+  for (size_t index = 0; index < 3; ++index) {
+    CheckNearlyEqual(nested->GetLayer(index)->GetWeights(), reference->GetLayer(index)->GetWeights());
+  }
+#endif
+
+  // a failing stage stops the whole pipeline instead of leaving the others waiting
+  auto wrongFeatures = nnn::FloatMatrix::Random(6, batchSize, -1.0f, 1.0f);
+  REQUIRE_THROWS_AS(pipelined->RunTrainingStep(wrongFeatures, labels), nnn::FloatMatrixInvalidDimensionException);
+}
+
+TEST_CASE("NeuralNetwork - Sharded dense layers train like dense layers") {  //
+
+  const size_t batchSize = 12;
+  auto createNetwork = [](bool isSharded) {
+    nnn::NormalHeWeightInitializer initializer(19);
+    auto network = std::make_unique<nnn::NeuralNetwork>(
+        nnn::NeuralNetwork::HyperParameters{.learningRate = 0.05f, .weightDecay = 0.01f, .momentum = 0.9f});
+    if (isSharded) {
+      // uneven shards (11 rows in 3), the single shard keeps the whole layer
+      network->AddHiddenLayer(
+          std::make_unique<nnn::ShardedDenseLayer>(6, 11, 3, std::make_unique<nnn::LeakyReLU>(), initializer));
+      network->AddHiddenLayer(
+          std::make_unique<nnn::ShardedDenseLayer>(11, 5, 1, std::make_unique<nnn::ReLU>(), initializer));
+    } else {
+      network->AddHiddenLayer(
+          std::make_unique<nnn::DenseLayer>(6, 11, std::make_unique<nnn::LeakyReLU>(), initializer));
+      network->AddHiddenLayer(std::make_unique<nnn::DenseLayer>(11, 5, std::make_unique<nnn::ReLU>(), initializer));
+    }
+    network->SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(5, 3, initializer));
+    return network;
+  };
+
+  auto dense = createNetwork(false);
+  auto sharded = createNetwork(true);
+  REQUIRE(sharded->GetParameterCount() == dense->GetParameterCount());
+
+  auto features = nnn::FloatMatrix::Random(6, batchSize, -1.0f, 1.0f);
+  auto labels = CreateCyclicLabels(3, batchSize);
+
+  for (int step = 0; step < 5; ++step) {
+    dense->RunTrainingStep(features, labels);
+    sharded->RunTrainingStep(features, labels);
+  }
+
+  for (size_t index = 0; index < 3; ++index) {
+    CheckNearlyEqual(sharded->GetLayer(index)->GetWeights(), dense->GetLayer(index)->GetWeights());
+    CheckNearlyEqual(sharded->GetLayer(index)->GetBiases(), dense->GetLayer(index)->GetBiases());
+  }
+
+  // the clone owns the parameters of all its shards
+  auto clone = sharded->GetLayer(0)->Clone();
+  CheckNearlyEqual(clone->Forward(features), sharded->GetLayer(0)->Forward(features));
+  sharded->GetLayer(0)->GetWeights()(0, 0) += 1.0f;
+  REQUIRE(clone->GetWeights()(0, 0) != sharded->GetLayer(0)->GetWeights()(0, 0));
+
+  nnn::NormalHeWeightInitializer initializer(19);
+  REQUIRE_THROWS_AS(nnn::ShardedDenseLayer(6, 11, 3, std::make_unique<nnn::Softmax>(), initializer),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(nnn::ShardedDenseLayer(6, 11, 12, std::make_unique<nnn::LeakyReLU>(), initializer),
+      std::invalid_argument);
+}
+
+TEST_CASE("NeuralNetwork - Accumulated gradients match one large batch") {  //
+
+  const size_t batchSize = 30;
+  auto createNetwork = []() {
+    nnn::NormalHeWeightInitializer initializer(23);
+    auto network = std::make_unique<nnn::NeuralNetwork>(
+        nnn::NeuralNetwork::HyperParameters{.learningRate = 0.05f, .weightDecay = 0.01f, .momentum = 0.9f});
+    network->AddHiddenLayer(std::make_unique<nnn::DenseLayer>(8, 7, std::make_unique<nnn::LeakyReLU>(), initializer));
+    network->SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(7, 3, initializer));
+    return network;
+  };
+
+  auto large = createNetwork();
+  auto accumulated = createNetwork();
+
+  auto features = nnn::FloatMatrix::Random(8, batchSize, -1.0f, 1.0f);
+  auto labels = CreateCyclicLabels(3, batchSize);
+
+  // batches of different sizes are weighted by their size
+  for (int step = 0; step < 3; ++step) {
+    large->RunTrainingStep(features, labels);
+    accumulated->AccumulateGradients(features.ViewColumns(0, 11), labels.ViewColumns(0, 11));
+    accumulated->AccumulateGradients(features.ViewColumns(12, 19), labels.ViewColumns(12, 19));
+    accumulated->AccumulateGradients(features.ViewColumns(20, 29), labels.ViewColumns(20, 29));
+    accumulated->ApplyAccumulatedGradients();
+  }
+
+  // nothing accumulated, nothing updated
+  accumulated->ApplyAccumulatedGradients();
+
+  for (size_t index = 0; index < 2; ++index) {
+    CheckNearlyEqual(accumulated->GetLayer(index)->GetWeights(), large->GetLayer(index)->GetWeights());
+    CheckNearlyEqual(accumulated->GetLayer(index)->GetBiases(), large->GetLayer(index)->GetBiases());
+  }
+}
+
+TEST_CASE("NeuralNetwork - Asynchronous training learns like synchronous training") {  //
+
+  // two classes separated by the diagonal
+  const size_t sampleCount = 1200;
+  auto features = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Random(2, sampleCount, -1.0f, 1.0f));
+  auto labels = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Zeroes(2, sampleCount));
+  for (size_t col = 0; col < sampleCount; ++col) {
+    (*labels)((*features)(0, col) > (*features)(1, col) ? 0 : 1, col) = 1.0f;
+  }
+  auto dataset = nnn::TrainingDataset(features, labels, {.batchSize = 20, .validationSetFraction = 0.25f});
+
+  auto train = [&](bool isAsynchronous) {
+    nnn::NormalHeWeightInitializer initializer(13);
+    auto network = nnn::NeuralNetwork({.learningRate = 0.05f,
+        .weightDecay = 0.0f,
+        .momentum = 0.9f,
+        .epochs = 8,
+        .dataParallelReplicas = 4,
+        .isAsynchronous = isAsynchronous});
+    network.AddHiddenLayer(std::make_unique<nnn::DenseLayer>(2, 16, std::make_unique<nnn::LeakyReLU>(), initializer));
+    network.SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(16, 2, initializer));
+
+    auto statistics = network.Train(dataset);
+    auto evaluation = nnn::TestDataSoftmaxEvaluator::Evaluate(
+        network.RunForwardPass(dataset.GetValidationFeatures()), dataset.GetValidationLabels());
+    return std::make_pair(statistics, static_cast<float>(evaluation.correctlyClassifiedCount) /
+                                          static_cast<float>(evaluation.totalExamplesCount));
+  };
+
+  auto [synchronous, synchronousAccuracy] = train(false);
+  auto [asynchronous, asynchronousAccuracy] = train(true);
+
+  CHECK(synchronous.samplesPerSecond > 0.0f);
+  CHECK(asynchronous.samplesPerSecond > 0.0f);
+  REQUIRE(asynchronous.trainingLosses.size() == 8);
+  CHECK(asynchronous.trainingLosses.back() < asynchronous.trainingLosses.front());
+  CHECK(synchronousAccuracy > 0.9f);
+  CHECK(asynchronousAccuracy > 0.9f);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_CASE("NeuralNetwork - Multi-process training matches single-process training") {  //
+
+  const size_t sampleCount = 300;
+  auto features = std::make_shared<nnn::FloatMatrix>(nnn::FloatMatrix::Random(5, sampleCount, -1.0f, 1.0f));
+  auto labels = std::make_shared<nnn::FloatMatrix>(CreateCyclicLabels(3, sampleCount));
+  // 3 processes share batches of 20, so the shards are not of equal size
+  auto dataset = nnn::TrainingDataset(features, labels, {.batchSize = 20, .validationSetFraction = 0.2f});
+
+  auto createNetwork = []() {
+    nnn::NormalHeWeightInitializer initializer(17);
+    auto network = std::make_unique<nnn::NeuralNetwork>(
+        nnn::NeuralNetwork::HyperParameters{
+            .learningRate = 0.05f, .weightDecay = 0.01f, .momentum = 0.9f, .epochs = 3});
+    network->AddHiddenLayer(std::make_unique<nnn::DenseLayer>(5, 8, std::make_unique<nnn::LeakyReLU>(), initializer));
+    network->SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(8, 3, initializer));
+    return network;
+  };
+
+  auto single = createNetwork();
+  single->Train(dataset);
+
+  auto distributed = createNetwork();
+  auto result =
+      nnn::ProcessGroup::Launch(3, distributed->GetParameterCount(), [&](nnn::ProcessGroup& group) {
+        distributed->SetProcessGroup(&group);
+        distributed->Train(dataset);
+        distributed->SetProcessGroup(nullptr);
+      });
+  REQUIRE(result.has_value());
+
+  for (size_t index = 0; index < 2; ++index) {
+    CheckNearlyEqual(distributed->GetLayer(index)->GetWeights(), single->GetLayer(index)->GetWeights(), 1e-4f);
+  }
+
+  // weighted average, rank 0 sees the same result as all the others (more elements than processes, and fewer)
+  for (size_t count : {7, 2}) {
+    std::vector<float> average(count);
+    auto averageResult = nnn::ProcessGroup::Launch(3, 7, [&](nnn::ProcessGroup& group) {
+      const float rank = static_cast<float>(group.GetRank());
+      for (size_t i = 0; i < count; ++i) {
+        average[i] = (rank + 1) * (i + 1);
+      }
+      group.AllReduceAverage(average.data(), count, rank + 1);
+    });
+    REQUIRE(averageResult.has_value());
+    for (size_t i = 0; i < count; ++i) {
+      CHECK_THAT(average[i], Catch::Matchers::WithinAbs((1.0f + 4.0f + 9.0f) / 6.0f * (i + 1), 1e-5f));
+    }
+  }
+
+  // a failure in one process stops the others at their next exchange
+  auto failure = nnn::ProcessGroup::Launch(3, 4, [](nnn::ProcessGroup& group) {
+    if (group.GetRank() == 1) {
+      throw std::runtime_error("Expected failure.");
+    }
+    float data[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    group.AllReduceAverage(data, 4, 1.0f);
+  });
+  REQUIRE(failure.has_error());
+  CHECK(failure.error() == "Training process 1 failed.");
+}
+#endif
+
+TEST_CASE("Optimizers - Adam, AdamW and RMSProp follow their update rules") {  //
+
+  const size_t batchSize = 8;
+  const float learningRate = 0.01f;
+  const float weightDecay = 0.1f;
+
+  // reference implementation of a single element update, returns the new parameter
+  std::function<float(float, float, float&, float&, int)> reference;
+  std::unique_ptr<nnn::IOptimizer> optimizer;
+
+  SECTION("Adam") {
+    optimizer = std::make_unique<nnn::AdamOptimizer>(nnn::AdamOptimizer::Parameters{.weightDecay = weightDecay});
+    reference = [=](float w, float g, float& m, float& v, int t) {
+      g += weightDecay * w;
+      m = 0.9f * m + 0.1f * g;
+      v = 0.999f * v + 0.001f * g * g;
+      const float mHat = m / (1 - std::pow(0.9f, t));
+      const float vHat = v / (1 - std::pow(0.999f, t));
+      return w - learningRate * mHat / (std::sqrt(vHat) + 1e-8f);
+    };
+  }
+
+  SECTION("AdamW") {
+    optimizer = std::make_unique<nnn::AdamOptimizer>(
+        nnn::AdamOptimizer::Parameters{.weightDecay = weightDecay, .isWeightDecayDecoupled = true});
+    reference = [=](float w, float g, float& m, float& v, int t) {
+      m = 0.9f * m + 0.1f * g;
+      v = 0.999f * v + 0.001f * g * g;
+      const float mHat = m / (1 - std::pow(0.9f, t));
+      const float vHat = v / (1 - std::pow(0.999f, t));
+      return w * (1 - learningRate * weightDecay) - learningRate * mHat / (std::sqrt(vHat) + 1e-8f);
+    };
+  }
+
+  SECTION("RMSProp") {
+    optimizer = std::make_unique<nnn::RMSPropOptimizer>(
+        nnn::RMSPropOptimizer::Parameters{.momentum = 0.5f, .weightDecay = weightDecay});
+    reference = [=](float w, float g, float& velocity, float& meanSquare, int) {
+      g += weightDecay * w;
+      meanSquare = 0.99f * meanSquare + 0.01f * g * g;
+      velocity = 0.5f * velocity + g / (std::sqrt(meanSquare) + 1e-8f);
+      return w - learningRate * velocity;
+    };
+  }
+
+  nnn::NormalGlorotWeightInitializer initializer(5);
+  auto network = nnn::NeuralNetwork({.learningRate = learningRate});
+  network.SetOutputLayer(std::make_unique<nnn::SoftmaxDenseOutputLayer>(batchSize, 4, 3, initializer));
+  network.SetOptimizer(std::move(optimizer));
+  nnn::ILayer& layer = *network.GetLayer(0);
+
+  auto features = nnn::FloatMatrix::Random(4, batchSize, -1.0f, 1.0f);
+  auto labels = CreateCyclicLabels(3, batchSize);
+
+  auto loss = [&]() {
+    const nnn::FloatMatrix& output = network.RunForwardPass(features);
+    float sum = 0.0f;
+    for (size_t col = 0; col < batchSize; ++col) {
+      sum -= std::log(output(col % 3, col));
+    }
+    return sum / batchSize;
+  };
+
+  const float initialLoss = loss();
+  nnn::FloatMatrix firstMoment = nnn::FloatMatrix::Zeroes(3, 4);
+  nnn::FloatMatrix secondMoment = nnn::FloatMatrix::Zeroes(3, 4);
+
+  for (int step = 1; step <= 3; ++step) {
+    const nnn::FloatMatrix& output = network.RunForwardPass(features);
+    nnn::FloatMatrix gradient = nnn::CrossEntropyWithSoftmax().Loss(output, labels) * (1.0f / batchSize);
+    network.RunBackwardPass(gradient);
+
+    nnn::FloatMatrix expected = layer.GetWeights();
+    const nnn::FloatMatrix& weightsGradient = layer.GetWeightsGradient();
+    for (size_t row = 0; row < expected.GetRowCount(); ++row) {
+      for (size_t col = 0; col < expected.GetColCount(); ++col) {
+        expected(row, col) = reference(
+            expected(row, col), weightsGradient(row, col), firstMoment(row, col), secondMoment(row, col), step);
+      }
+    }
+
+    network.UpdateWeights();
+
+    float maxDifference = 0.0f;
+    for (size_t row = 0; row < expected.GetRowCount(); ++row) {
+      for (size_t col = 0; col < expected.GetColCount(); ++col) {
+        maxDifference = std::max(maxDifference, std::abs(layer.GetWeights()(row, col) - expected(row, col)));
+      }
+    }
+    CHECK(maxDifference < 1e-6f);
+  }
+
+  for (int step = 0; step < 50; ++step) {
+    network.RunTrainingStep(features, labels);
+  }
+  CHECK(loss() < initialLoss);
+}
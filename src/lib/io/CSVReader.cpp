@@ -1,70 +1,197 @@
 #include "CSVReader.hpp"
 
-#include <exception>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <iosfwd>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
-cpp::result<std::shared_ptr<nnn::FloatMatrix>, nnn::IoError> nnn::CSVReader::Read(std::filesystem::path filepath) {  //
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+
+namespace {
+
+  // the file is split into chunks of about this many bytes (at line ends), which are parsed in parallel
+  constexpr size_t CHUNK_BYTES = 1024 * 1024;
 
-  std::ifstream inputFile;
-  inputFile.open(filepath);
+  /**
+   * @brief Calls `func(line)` for every non-empty line of the text, without the line end (`\n` or `\r\n`). Stops early
+   * when `func` returns false.
+   */
+  template <typename Func>
+  void ForEachLine(std::string_view text, Func&& func) {  //
 
-  if (!inputFile.is_open()) {
-    try {
-      std::filesystem::path absolute_filepath = std::filesystem::absolute(filepath);
-      return cpp::fail("File <" + absolute_filepath.string() + "> was not found or access denied.");
-    } catch (const std::filesystem::filesystem_error& e) {
-      return cpp::fail("Error resolving path: <" + filepath.string() + ">. Details: " + e.what());
+    while (!text.empty()) {
+      const size_t end = std::min(text.find('\n'), text.size());
+      std::string_view line = text.substr(0, end);
+      text.remove_prefix(std::min(end + 1, text.size()));
+
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+      if (!line.empty() && !func(line)) {
+        return;
+      }
     }
   }
 
-  std::vector<float> rawData;
-  int rows = 0;
-  int cols = 0;
+  /**
+   * @brief Calls `func(cell)` for every cell of the line. A delimiter at the end of the line does not start another
+   * cell. Stops early when `func` returns false.
+   */
+  template <typename Func>
+  void ForEachCell(std::string_view line, char delimiter, Func&& func) {  //
+
+    while (true) {
+      const size_t end = line.find(delimiter);
+      if (!func(line.substr(0, end)) || end == std::string_view::npos || end + 1 == line.size()) {
+        return;
+      }
+      line.remove_prefix(end + 1);
+    }
+  }
 
-  std::string line;
-  while (std::getline(inputFile, line)) {  //
+  bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f'; }
 
-    if (line.empty()) {
-      continue;
+  /**
+   * @brief Parses the whole cell as a float, surrounding whitespace and a leading plus sign are allowed.
+   */
+  std::errc ParseCell(std::string_view cell, float& value) {  //
+
+    const char* begin = cell.data();
+    const char* end = cell.data() + cell.size();
+    while (begin != end && IsSpace(*begin)) {
+      ++begin;
+    }
+    while (begin != end && IsSpace(*(end - 1))) {
+      --end;
+    }
+    if (begin != end && *begin == '+' && end - begin > 1 && *(begin + 1) != '-') {
+      ++begin;
     }
 
-    std::stringstream ss(line);
-    std::string cell;
-    int current_cols = 0;
-
-    while (std::getline(ss, cell, m_delimiter)) {
-      try {
-        float value = std::stof(cell);
-        rawData.push_back(value);
-        current_cols++;
-      } catch (const std::exception& e) {
-        inputFile.close();
-        std::string error_msg = "Error while parsing float in file at line <" + std::to_string(rows + 1) +
-                                ">, cell value: <" + cell + ">! Details: <" + e.what() + ">.";
-        return cpp::fail(error_msg);
-      }
+    auto [parsed, error] = std::from_chars(begin, end, value);
+    if (error == std::errc() && (parsed != end || begin == end)) {
+      return std::errc::invalid_argument;
     }
+    return error;
+  }
+
+  size_t CountCells(std::string_view line, char delimiter) {  //
+
+    size_t count = 0;
+    ForEachCell(line, delimiter, [&count](std::string_view) {
+      ++count;
+      return true;
+    });
+    return count;
+  }
+
+  struct ChunkResult {
+    size_t rows = 0;
+    // the row of the first error in the chunk, SIZE_MAX if there is none
+    size_t errorRow = SIZE_MAX;
+    std::string error;
+  };
+}  // namespace
 
-    if (rows == 0) {
-      cols = current_cols;
-    } else if (current_cols != cols) {
-      inputFile.close();
-      std::string error_msg = "Inconsistent column count at line <" + std::to_string(rows + 1) + ">. Found <" +
-                              std::to_string(current_cols) + "> columns, but expected <" + std::to_string(cols) + ">!";
-      return cpp::fail(error_msg);
+cpp::result<std::shared_ptr<nnn::FloatMatrix>, nnn::IoError> nnn::CSVReader::Read(std::filesystem::path filepath) {  //
+
+  auto file = MappedFile::Open(filepath);
+  if (file.has_error()) {
+    return cpp::fail(file.error());
+  }
+  const std::string_view text = file.value().GetContents();
+
+  // the line-aligned chunks, chunk i is [boundaries[i], boundaries[i + 1])
+  std::vector<size_t> boundaries = {0};
+  const size_t chunkCount = std::max(size_t(1), text.size() / CHUNK_BYTES);
+  for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+    const size_t lineEnd = text.find('\n', std::max(boundaries.back(), chunk * text.size() / chunkCount));
+    if (lineEnd == std::string_view::npos) {
+      break;
     }
+    boundaries.push_back(lineEnd + 1);
+  }
+  boundaries.push_back(text.size());
+  std::vector<ChunkResult> chunks(boundaries.size() - 1);
+
+  auto chunkText = [&](size_t chunk) {
+    return text.substr(boundaries[chunk], boundaries[chunk + 1] - boundaries[chunk]);
+  };
+
+  // the first line defines the column count
+  size_t cols = 0;
+  ForEachLine(text, [&](std::string_view line) {
+    cols = CountCells(line, m_delimiter);
+    return false;
+  });
+
+  // first pass: the rows of every chunk, so that each chunk knows where its rows go in the matrix
+  Parallel::For(chunks.size(), text.size(), [&](size_t chunk) {
+    ForEachLine(chunkText(chunk), [&](std::string_view) {
+      ++chunks[chunk].rows;
+      return true;
+    });
+  });
 
-    rows++;
+  size_t rows = 0;
+  std::vector<size_t> firstRows(chunks.size());
+  for (size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    firstRows[chunk] = rows;
+    rows += chunks[chunk].rows;
+  }
+
+  auto matrix = std::make_shared<FloatMatrix>(rows, cols);
+
+  // second pass: the values are parsed straight into their rows of the matrix
+  Parallel::For(chunks.size(), text.size(), [&](size_t chunk) {
+    ChunkResult& result = chunks[chunk];
+    size_t row = firstRows[chunk];
+
+    ForEachLine(chunkText(chunk), [&](std::string_view line) {
+      float* values = matrix->Data() + row * matrix->GetRowStride();
+      size_t col = 0;
+
+      ForEachCell(line, m_delimiter, [&](std::string_view cell) {
+        float value = 0.0f;
+        const std::errc error = ParseCell(cell, value);
+        if (error != std::errc()) {
+          result.errorRow = row;
+          result.error = "Error while parsing float in file at line <" + std::to_string(row + 1) + ">, cell value: <" +
+                         std::string(cell) + ">! Details: <" + std::make_error_code(error).message() + ">.";
+          return false;
+        }
+        if (col < cols) {
+          values[col] = value;
+        }
+        ++col;
+        return true;
+      });
+
+      if (result.errorRow == SIZE_MAX && col != cols) {
+        result.errorRow = row;
+        result.error = "Inconsistent column count at line <" + std::to_string(row + 1) + ">. Found <" +
+                       std::to_string(col) + "> columns, but expected <" + std::to_string(cols) + ">!";
+      }
+      ++row;
+      return result.errorRow == SIZE_MAX;
+    });
+  });
+
+  // the chunks are in file order, so the first error of the first failed chunk is the first error of the file
+  for (const ChunkResult& result : chunks) {
+    if (result.errorRow != SIZE_MAX) {
+      return cpp::fail(result.error);
+    }
   }
 
-  inputFile.close();
-  return std::make_shared<nnn::FloatMatrix>(rows, cols, std::move(rawData));
+  return matrix;
 }
 
 bool nnn::CSVReader::IsValid(
@@ -8,6 +8,11 @@ namespace nnn {
    public:
     CSVReader(char delimiter = ',') : m_delimiter(delimiter) {}
     cpp::result<std::shared_ptr<FloatMatrix>, IoError> Read(std::filesystem::path filepath) override;
+
+    // "CSV" followed by the delimiter
+    inline uint64_t GetFingerprint() const override {
+      return 0x435356ull << 40 | static_cast<unsigned char>(m_delimiter);
+    }
     static bool IsValid(
         cpp::result<std::shared_ptr<FloatMatrix>, IoError> result, size_t expectedCols, size_t expectedRows);
 
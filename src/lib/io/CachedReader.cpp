@@ -0,0 +1,179 @@
+#include "CachedReader.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <system_error>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+namespace {
+
+  constexpr char MAGIC[8] = {'N', 'N', 'N', 'C', 'A', 'C', 'H', 'E'};
+  constexpr uint32_t VERSION = 2;
+
+  enum class ValueType : uint32_t { FLOAT32 = 1 };
+
+  /**
+   * @brief The header of the cache file, the values follow right after it (64-byte aligned).
+   */
+  struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    ValueType valueType;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t sourceSize;
+    int64_t sourceModificationTime;
+    uint64_t sourceHash;
+    uint64_t readerFingerprint;
+  };
+
+  static_assert(sizeof(CacheHeader) == 64);
+
+  /**
+   * @brief 64-bit FNV-1a over 8-byte words (and the remaining bytes), about as fast as the file can be read.
+   */
+  uint64_t HashContents(std::string_view contents) {  //
+
+    constexpr uint64_t OFFSET_BASIS = 14695981039346656037ull;
+    constexpr uint64_t PRIME = 1099511628211ull;
+
+    uint64_t hash = OFFSET_BASIS;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= contents.size(); i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, contents.data() + i, sizeof(word));
+      hash = (hash ^ word) * PRIME;
+    }
+    for (; i < contents.size(); ++i) {
+      hash = (hash ^ static_cast<unsigned char>(contents[i])) * PRIME;
+    }
+    return hash;
+  }
+
+  /**
+   * @return the hash of the file, or nothing when it cannot be read.
+   */
+  std::optional<uint64_t> HashFile(const std::filesystem::path& filepath) {  //
+
+    auto file = nnn::MappedFile::Open(filepath);
+    if (file.has_error()) {
+      return std::nullopt;
+    }
+    return HashContents(file.value().GetContents());
+  }
+}  // namespace
+
+namespace nnn {
+
+  std::filesystem::path CachedReader::GetCachePath(const std::filesystem::path& filepath) {
+    return std::filesystem::path(filepath).concat(CACHE_EXTENSION);
+  }
+
+  cpp::result<std::shared_ptr<FloatMatrix>, IoError> CachedReader::Read(std::filesystem::path filepath) {  //
+
+    std::error_code error;
+    const uint64_t size = std::filesystem::file_size(filepath, error);
+    const auto modificationTime = std::filesystem::last_write_time(filepath, error);
+    if (error) {
+      // the source reader reports the missing file
+      return m_sourceReader->Read(filepath);
+    }
+
+    const SourceInfo source = {.size = size,
+        .modificationTime = modificationTime.time_since_epoch().count(),
+        .readerFingerprint = m_sourceReader->GetFingerprint()};
+    if (auto cached = ReadCache(filepath, source)) {
+      return cached;
+    }
+
+    auto result = m_sourceReader->Read(filepath);
+    if (result.has_value()) {
+      WriteCache(filepath, source, *result.value());
+    }
+    return result;
+  }
+
+  std::shared_ptr<FloatMatrix> CachedReader::ReadCache(
+      const std::filesystem::path& filepath, const SourceInfo& source) {  //
+
+    auto cache = MappedFile::Open(GetCachePath(filepath));
+    if (cache.has_error() || cache.value().GetSize() < sizeof(CacheHeader)) {
+      return nullptr;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, cache.value().Data(), sizeof(header));
+    const bool isValid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION &&
+                         header.valueType == ValueType::FLOAT32 && header.sourceSize == source.size &&
+                         header.readerFingerprint == source.readerFingerprint &&
+                         cache.value().GetSize() == sizeof(CacheHeader) + header.rows * header.cols * sizeof(float);
+    if (!isValid) {
+      return nullptr;
+    }
+
+    // a touched or copied source with the same contents keeps its cache
+    if (header.sourceModificationTime != source.modificationTime) {
+      if (HashFile(filepath) != header.sourceHash) {
+        return nullptr;
+      }
+      header.sourceModificationTime = source.modificationTime;
+      std::fstream output(GetCachePath(filepath), std::ios::binary | std::ios::in | std::ios::out);
+      output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    auto matrix = std::make_shared<FloatMatrix>(header.rows, header.cols);
+    std::memcpy(matrix->Data(), cache.value().Data() + sizeof(CacheHeader), header.rows * header.cols * sizeof(float));
+    return matrix;
+  }
+
+  void CachedReader::WriteCache(
+      const std::filesystem::path& filepath, const SourceInfo& source, const FloatMatrix& matrix) {  //
+
+    const std::optional<uint64_t> hash = HashFile(filepath);
+    if (!hash) {
+      return;
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.valueType = ValueType::FLOAT32;
+    header.rows = matrix.GetRowCount();
+    header.cols = matrix.GetColCount();
+    header.sourceSize = source.size;
+    header.sourceModificationTime = source.modificationTime;
+    header.sourceHash = *hash;
+    header.readerFingerprint = source.readerFingerprint;
+
+    // written under a temporary name and renamed, so that a reader never sees a partial cache
+    const std::filesystem::path cachePath = GetCachePath(filepath);
+    std::filesystem::path temporaryPath = std::filesystem::path(cachePath).concat(".tmp");
+    {
+      std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+      output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+      std::vector<float> row(matrix.GetColCount());
+      for (size_t r = 0; r < matrix.GetRowCount() && output; ++r) {
+        for (size_t c = 0; c < matrix.GetColCount(); ++c) {
+          row[c] = matrix(r, c);
+        }
+        output.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+      }
+      if (!output) {
+        output.close();
+        std::error_code error;
+        std::filesystem::remove(temporaryPath, error);
+        return;
+      }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error) {
+      std::filesystem::remove(temporaryPath, error);
+    }
+  }
+}  // namespace nnn
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "IReader.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Reads matrices through another reader (e.g. `CSVReader`) once and keeps them in a binary cache file next to
+   * the source (`<source>.nnncache`). Later reads memory-map the cache, which only copies the raw values.
+   *
+   * The cache starts with a versioned header (rows, cols, value type, the fingerprint of the source reader and the
+   * size, modification time and hash of the source) followed by the values in row-major order. It is used while it was
+   * written by a reader with the same fingerprint (e.g. the same delimiter) and the source has the same size and either
+   * the same modification time or the same hash, otherwise the source is parsed again and the cache is rewritten. A
+   * cache which cannot be written is not an error, the matrix is returned anyway.
+   */
+  class CachedReader : public IReader {
+   public:
+    static constexpr const char* CACHE_EXTENSION = ".nnncache";
+
+    CachedReader(std::shared_ptr<IReader> sourceReader) : m_sourceReader(std::move(sourceReader)) {}
+    cpp::result<std::shared_ptr<FloatMatrix>, IoError> Read(std::filesystem::path filepath) override;
+    inline uint64_t GetFingerprint() const override { return m_sourceReader->GetFingerprint(); }
+
+    static std::filesystem::path GetCachePath(const std::filesystem::path& filepath);
+
+   private:
+    struct SourceInfo {
+      uint64_t size;
+      int64_t modificationTime;
+      uint64_t readerFingerprint;
+    };
+
+    std::shared_ptr<IReader> m_sourceReader;
+
+    /**
+     * @return the cached matrix, or nothing when there is no valid cache for the source.
+     */
+    static std::shared_ptr<FloatMatrix> ReadCache(const std::filesystem::path& filepath, const SourceInfo& source);
+    static void WriteCache(const std::filesystem::path& filepath, const SourceInfo& source, const FloatMatrix& matrix);
+  };
+
+}  // namespace nnn
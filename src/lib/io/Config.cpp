@@ -41,6 +41,63 @@ cpp::result<void, std::string> nnn::Config::LoadFromJSON(std::filesystem::path c
     return cpp::fail("Failed to parse 'hardThreadsLimit': " + std::string(e.what()));
   }
 
+  try {
+    parallelElementThreshold = config.value("parallelElementThreshold", size_t(0));
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'parallelElementThreshold': " + std::string(e.what()));
+  }
+
+  try {
+    dataParallelReplicas = config.value("dataParallelReplicas", size_t(1));
+    if (dataParallelReplicas == 0) {
+      return cpp::fail("'dataParallelReplicas' must be at least 1.");
+    }
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'dataParallelReplicas': " + std::string(e.what()));
+  }
+
+  try {
+    asynchronousTraining = config.value("asynchronousTraining", false);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'asynchronousTraining': " + std::string(e.what()));
+  }
+
+  try {
+    processes = config.value("processes", size_t(1));
+    if (processes == 0) {
+      return cpp::fail("'processes' must be at least 1.");
+    }
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'processes': " + std::string(e.what()));
+  }
+
+  try {
+    pipelineMicroBatches = config.value("pipelineMicroBatches", size_t(1));
+    if (pipelineMicroBatches == 0) {
+      return cpp::fail("'pipelineMicroBatches' must be at least 1.");
+    }
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'pipelineMicroBatches': " + std::string(e.what()));
+  }
+
+  try {
+    tensorParallelShards = config.value("tensorParallelShards", size_t(1));
+    if (tensorParallelShards == 0) {
+      return cpp::fail("'tensorParallelShards' must be at least 1.");
+    }
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'tensorParallelShards': " + std::string(e.what()));
+  }
+
+  try {
+    gradientAccumulationSteps = config.value("gradientAccumulationSteps", size_t(1));
+    if (gradientAccumulationSteps == 0) {
+      return cpp::fail("'gradientAccumulationSteps' must be at least 1.");
+    }
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'gradientAccumulationSteps': " + std::string(e.what()));
+  }
+
   try {
     learningRate = config.value("learningRate", 0.01f);
   } catch (const nlohmann::json::exception& e) {
@@ -65,6 +122,39 @@ cpp::result<void, std::string> nnn::Config::LoadFromJSON(std::filesystem::path c
     return cpp::fail("Failed to parse 'momentum': " + std::string(e.what()));
   }
 
+  try {
+    optimizer = config.value("optimizer", std::string("momentum"));
+    if (optimizer != "momentum" && optimizer != "adam" && optimizer != "adamw" && optimizer != "rmsprop") {
+      return cpp::fail("Unknown optimizer '" + optimizer + "', expected 'momentum', 'adam', 'adamw' or 'rmsprop'.");
+    }
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'optimizer': " + std::string(e.what()));
+  }
+
+  try {
+    beta1 = config.value("beta1", 0.9f);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'beta1': " + std::string(e.what()));
+  }
+
+  try {
+    beta2 = config.value("beta2", 0.999f);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'beta2': " + std::string(e.what()));
+  }
+
+  try {
+    epsilon = config.value("epsilon", 1e-8f);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'epsilon': " + std::string(e.what()));
+  }
+
+  try {
+    rmspropDecay = config.value("rmspropDecay", 0.99f);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'rmspropDecay': " + std::string(e.what()));
+  }
+
   try {
     epochs = config.value("epochs", 10);
   } catch (const nlohmann::json::exception& e) {
@@ -83,6 +173,33 @@ cpp::result<void, std::string> nnn::Config::LoadFromJSON(std::filesystem::path c
     return cpp::fail("Failed to parse 'validationSetFraction': " + std::string(e.what()));
   }
 
+  try {
+    isDatasetCached = config.value("datasetCache", true);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'datasetCache': " + std::string(e.what()));
+  }
+
+  try {
+    isFeatureStorageCompact = config.value("compactFeatures", false);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'compactFeatures': " + std::string(e.what()));
+  }
+
+  try {
+    areLabelsClassIndices = config.value("classIndexLabels", false);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse 'classIndexLabels': " + std::string(e.what()));
+  }
+
+  try {
+    trainingFeaturesPath = config.value("trainingFeatures", trainingFeaturesPath);
+    trainingLabelsPath = config.value("trainingLabels", trainingLabelsPath);
+    testingFeaturesPath = config.value("testingFeatures", testingFeaturesPath);
+    testingLabelsPath = config.value("testingLabels", testingLabelsPath);
+  } catch (const nlohmann::json::exception& e) {
+    return cpp::fail("Failed to parse the dataset paths: " + std::string(e.what()));
+  }
+
   try {
     const auto& layer_sizes_array = config.value("layers", nlohmann::json::array());
 
@@ -105,6 +222,22 @@ cpp::result<void, std::string> nnn::Config::LoadFromJSON(std::filesystem::path c
     expectedClassNumber = layers.back();
   }
 
+  if (processes > 1 && (dataParallelReplicas > 1 || asynchronousTraining)) {
+    return cpp::fail("'processes' cannot be combined with 'dataParallelReplicas' or 'asynchronousTraining'.");
+  }
+  if (processes > batchSize) {
+    return cpp::fail("'processes' must not be greater than 'batchSize'.");
+  }
+  if (pipelineMicroBatches > 1 && (dataParallelReplicas > 1 || processes > 1)) {
+    return cpp::fail("'pipelineMicroBatches' cannot be combined with 'dataParallelReplicas' or 'processes'.");
+  }
+  if (tensorParallelShards > 1 && processes > 1) {
+    return cpp::fail("'tensorParallelShards' cannot be combined with 'processes'.");
+  }
+  if (gradientAccumulationSteps > 1 && asynchronousTraining) {
+    return cpp::fail("'gradientAccumulationSteps' cannot be combined with 'asynchronousTraining'.");
+  }
+
   return {};
 }
 
@@ -118,14 +251,40 @@ std::string nnn::Config::ToString() const {  //
   oss << "General settings:\n";
   oss << "  Random seed:            " << randomSeed << "\n";
   oss << "  Hard threads limit:     " << hardThreadsLimit << "\n";
+  oss << "  Parallel threshold:     ";
+  if (parallelElementThreshold == 0) {
+    oss << "(measured at startup)\n";
+  } else {
+    oss << parallelElementThreshold << "\n";
+  }
+  oss << "  Training processes:     " << processes << "\n";
+  oss << "  Data-parallel replicas: " << dataParallelReplicas;
+  oss << (asynchronousTraining && dataParallelReplicas > 1 ? " (asynchronous)\n" : "\n");
+  oss << "  Pipeline micro-batches: " << pipelineMicroBatches << "\n";
+  oss << "  Tensor-parallel shards: " << tensorParallelShards << "\n";
+  oss << "  Accumulation steps:     " << gradientAccumulationSteps << "\n";
   oss << "  Learning rate:          " << learningRate << "\n";
   oss << "  Learning rate decay:    " << learningRateDecay << "\n";
   oss << "  Weight decay:           " << weightDecay << "\n";
   oss << "  Momentum:               " << momentum << "\n";
+  oss << "  Optimizer:              " << optimizer << "\n";
+  if (optimizer == "rmsprop") {
+    oss << "  RMSProp decay:          " << rmspropDecay << "\n";
+  } else if (optimizer != "momentum") {
+    oss << "  Beta1, beta2:           " << beta1 << ", " << beta2 << "\n";
+  }
+  if (optimizer != "momentum") {
+    oss << "  Epsilon:                " << std::scientific << epsilon << std::fixed << "\n";
+  }
   oss << "  Epochs:                 " << epochs << "\n";
   oss << "  Batch size:             " << batchSize << "\n";
   oss << "  Validation fraction:    " << validationSetFraction << "\n";
   oss << "  Expected classes:       " << expectedClassNumber << "\n";
+  oss << "  Dataset cache:          " << (isDatasetCached ? "on" : "off") << "\n";
+  oss << "  Compact features:       " << (isFeatureStorageCompact ? "on" : "off") << "\n";
+  oss << "  Class index labels:     " << (areLabelsClassIndices ? "on" : "off") << "\n";
+  oss << "  Training files:         " << trainingFeaturesPath << ", " << trainingLabelsPath << "\n";
+  oss << "  Testing files:          " << testingFeaturesPath << ", " << testingLabelsPath << "\n";
 
   oss << "\nLayers (total " << layers.size() - 1 << " layers):\n";
 
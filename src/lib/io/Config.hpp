@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <result.hpp>
 
@@ -12,15 +13,48 @@ namespace nnn {
    public:
     int randomSeed = 42;
     int hardThreadsLimit = std::thread::hardware_concurrency();
+    // element-wise operations on fewer elements run serially, 0 means it is measured at startup
+    size_t parallelElementThreshold = 0;
+    // the batch is split between this many model replicas, each trained on its own thread (1 disables data parallelism)
+    size_t dataParallelReplicas = 1;
+    // the replicas train on their own batches and update the shared weights without locks (Hogwild)
+    bool asynchronousTraining = false;
+    // number of forked single-threaded training processes averaging their gradients through shared memory
+    size_t processes = 1;
+    // every layer runs on its own thread and the batch is streamed through them in this many micro-batches
+    size_t pipelineMicroBatches = 1;
+    // the hidden layers are split by output rows into this many shards, each computed on its own thread
+    size_t tensorParallelShards = 1;
+    // the weights are updated once per this many batches, with the average of their gradients
+    size_t gradientAccumulationSteps = 1;
     float learningRate = 0.01f;
     float learningRateDecay = 1.0f;
     float weightDecay = 1.0f;
     float momentum = 0.0f;
+    // one of "momentum", "adam", "adamw" or "rmsprop"
+    std::string optimizer = "momentum";
+    // decay rates of the moment estimates of Adam and the stabilizing constant (also used by RMSProp)
+    float beta1 = 0.9f;
+    float beta2 = 0.999f;
+    float epsilon = 1e-8f;
+    // decay rate of the mean square of RMSProp
+    float rmspropDecay = 0.99f;
     size_t epochs = 10;
     size_t batchSize = 256;
     float validationSetFraction = 0.2;
     size_t expectedClassNumber = 10;
     std::vector<size_t> layers = {};
+    // the parsed CSV files are kept in binary cache files next to them, see `CachedReader`
+    bool isDatasetCached = true;
+    // the training features are kept as bytes (4x less memory) and normalized while the batches are gathered
+    bool isFeatureStorageCompact = false;
+    // the labels are kept as class indices (2 bytes per sample) instead of one-hot encoded floats
+    bool areLabelsClassIndices = false;
+    // paths of the dataset relative to the project directory, CSV or IDX files (e.g. "data/train-images-idx3-ubyte")
+    std::string trainingFeaturesPath = "data/fashion_mnist_train_vectors.csv";
+    std::string trainingLabelsPath = "data/fashion_mnist_train_labels.csv";
+    std::string testingFeaturesPath = "data/fashion_mnist_test_vectors.csv";
+    std::string testingLabelsPath = "data/fashion_mnist_test_labels.csv";
 
     Config() = default;
     cpp::result<void, std::string> LoadFromJSON(std::filesystem::path configFilePath);
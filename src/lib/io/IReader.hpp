@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 
 #include "result.hpp"
@@ -15,6 +16,13 @@ namespace nnn {
    public:
     virtual ~IReader() = 0;
     virtual cpp::result<std::shared_ptr<FloatMatrix>, IoError> Read(std::filesystem::path filepath) = 0;
+
+    /**
+     * @brief Identifies the reader and its settings which change the result (e.g. the delimiter), so that results of
+     * readers which may read the same file differently are not mixed up (see `CachedReader`). Every reader has to
+     * provide its own, a shared default would let different readers share cached matrices.
+     */
+    virtual uint64_t GetFingerprint() const = 0;
   };
 
   inline IReader::~IReader() = default;
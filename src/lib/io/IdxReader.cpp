@@ -0,0 +1,113 @@
+#include "IdxReader.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Parallel.hpp"
+
+namespace {
+
+  // the magic number is two zero bytes, the value type and the number of dimensions
+  constexpr unsigned char UNSIGNED_BYTE_TYPE = 0x08;
+
+  size_t ReadBigEndian(const unsigned char* bytes) {
+    return (size_t(bytes[0]) << 24) | (size_t(bytes[1]) << 16) | (size_t(bytes[2]) << 8) | size_t(bytes[3]);
+  }
+}  // namespace
+
+bool nnn::IdxReader::IsIdxPath(const std::filesystem::path& filepath) {  //
+
+  const std::string filename = filepath.filename().string();
+  const std::string extension = filepath.extension().string();
+  return (filename.size() >= 5 && filename.compare(filename.size() - 5, 5, "ubyte") == 0) || extension == ".idx" ||
+         extension == ".idx1" || extension == ".idx3";
+}
+
+cpp::result<nnn::IdxReader::Contents, nnn::IoError> nnn::IdxReader::Map(const std::filesystem::path& filepath) {  //
+
+  auto file = MappedFile::Open(filepath);
+  if (file.has_error()) {
+    return cpp::fail(file.error());
+  }
+
+  const auto* bytes = reinterpret_cast<const unsigned char*>(file.value().Data());
+  const size_t size = file.value().GetSize();
+  auto invalid = [&filepath](const std::string& reason) -> IoError {
+    return "File <" + filepath.string() + "> is not a valid IDX file: " + reason + ".";
+  };
+
+  if (size < 4 || bytes[0] != 0 || bytes[1] != 0) {
+    return cpp::fail(invalid("wrong magic number"));
+  }
+  if (bytes[2] != UNSIGNED_BYTE_TYPE) {
+    return cpp::fail(invalid("only unsigned byte values are supported"));
+  }
+
+  // the first dimension are the items, the others are flattened into the values of an item
+  const size_t dimensions = bytes[3];
+  const size_t headerSize = 4 + 4 * dimensions;
+  if (dimensions == 0 || size < headerSize) {
+    return cpp::fail(invalid("truncated header"));
+  }
+  // the dimensions come from the file, their product must not overflow before it is compared with the file size
+  const size_t items = ReadBigEndian(bytes + 4);
+  size_t itemSize = 1;
+  for (size_t dimension = 1; dimension < dimensions; ++dimension) {
+    const size_t dimensionSize = ReadBigEndian(bytes + 4 + 4 * dimension);
+    if (dimensionSize != 0 && itemSize > SIZE_MAX / dimensionSize) {
+      return cpp::fail(invalid("dimensions too large"));
+    }
+    itemSize *= dimensionSize;
+  }
+  if (itemSize != 0 && items > (SIZE_MAX - headerSize) / itemSize) {
+    return cpp::fail(invalid("dimensions too large"));
+  }
+  if (size != headerSize + items * itemSize) {
+    return cpp::fail(invalid("expected " + std::to_string(items * itemSize) + " values, found " +
+                             std::to_string(size - headerSize)));
+  }
+
+  return Contents{.file = std::move(file.value()), .items = items, .itemSize = itemSize, .headerSize = headerSize};
+}
+
+cpp::result<std::shared_ptr<nnn::FloatMatrix>, nnn::IoError> nnn::IdxReader::Read(std::filesystem::path filepath) {  //
+
+  auto contents = Map(filepath);
+  if (contents.has_error()) {
+    return cpp::fail(contents.error());
+  }
+  const size_t rows = contents.value().items;
+  const size_t cols = contents.value().itemSize;
+
+  // The items are stored one after another, which is the row-major layout of the matrix (and the column-major layout
+  // of its transposition, with the items as the columns), so the values are converted in storage order.
+  auto matrix = std::make_shared<FloatMatrix>(rows, cols);
+  const auto* values =
+      reinterpret_cast<const unsigned char*>(contents.value().file.Data()) + contents.value().headerSize;
+  float* data = matrix->Data();
+  const float scale = 1.0f / m_normalizationFactor;
+
+  Parallel::ForChunks(rows * cols, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      data[i] = static_cast<float>(values[i]) * scale;
+    }
+  });
+
+  return matrix;
+}
+
+cpp::result<std::shared_ptr<nnn::ByteMatrix>, nnn::IoError> nnn::IdxReader::ReadBytes(
+    std::filesystem::path filepath) {  //
+
+  auto contents = Map(filepath);
+  if (contents.has_error()) {
+    return cpp::fail(contents.error());
+  }
+
+  const auto* values = reinterpret_cast<const uint8_t*>(contents.value().file.Data()) + contents.value().headerSize;
+  std::vector<uint8_t> data(values, values + contents.value().items * contents.value().itemSize);
+  return std::make_shared<ByteMatrix>(
+      contents.value().itemSize, contents.value().items, std::move(data), 1.0f / m_normalizationFactor);
+}
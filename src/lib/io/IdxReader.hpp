@@ -0,0 +1,55 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#include "ByteMatrix.hpp"
+#include "IReader.hpp"
+#include "MappedFile.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Reads the IDX files of (Fashion-)MNIST (`*-images-idx3-ubyte`, `*-labels-idx1-ubyte`) from a memory
+   * mapping. Every item of the file (an image, a label) becomes a row of the matrix and its values (pixels) the
+   * columns, converted from bytes and divided by the normalization factor in a single pass.
+   *
+   * Only unsigned byte values are supported, the files must not be compressed.
+   */
+  class IdxReader : public IReader {
+   public:
+    IdxReader(float normalizationFactor = 1.0f) : m_normalizationFactor(normalizationFactor) {}
+    cpp::result<std::shared_ptr<FloatMatrix>, IoError> Read(std::filesystem::path filepath) override;
+
+    // "IDX" followed by the bits of the normalization factor
+    inline uint64_t GetFingerprint() const override {
+      return 0x494458ull << 40 | std::bit_cast<uint32_t>(m_normalizationFactor);
+    }
+
+    /**
+     * @brief Reads the values without converting them, the items become the columns of the byte matrix (its storage
+     * order is the order of the file), which scales them by 1 / normalization factor on conversion.
+     */
+    cpp::result<std::shared_ptr<ByteMatrix>, IoError> ReadBytes(std::filesystem::path filepath);
+
+    /**
+     * @brief Whether the path names an IDX file (ends with `ubyte`, or has the extension `.idx`, `.idx1` or `.idx3`).
+     */
+    static bool IsIdxPath(const std::filesystem::path& filepath);
+
+   private:
+    struct Contents {
+      MappedFile file;
+      size_t items;
+      size_t itemSize;
+      size_t headerSize;
+    };
+
+    float m_normalizationFactor;
+
+    static cpp::result<Contents, IoError> Map(const std::filesystem::path& filepath);
+  };
+
+}  // namespace nnn
@@ -0,0 +1,100 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define NNN_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+  nnn::IoError NotFoundError(const std::filesystem::path& filepath) {  //
+
+    try {
+      std::filesystem::path absolute_filepath = std::filesystem::absolute(filepath);
+      return "File <" + absolute_filepath.string() + "> was not found or access denied.";
+    } catch (const std::filesystem::filesystem_error& e) {
+      return "Error resolving path: <" + filepath.string() + ">. Details: " + e.what();
+    }
+  }
+}  // namespace
+
+namespace nnn {
+
+  cpp::result<MappedFile, IoError> MappedFile::Open(const std::filesystem::path& filepath) {  //
+
+    MappedFile file;
+
+#ifdef NNN_HAS_MMAP
+    const int descriptor = open(filepath.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+      return cpp::fail(NotFoundError(filepath));
+    }
+
+    struct stat status = {};
+    if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)) {
+      close(descriptor);
+      return cpp::fail(NotFoundError(filepath));
+    }
+
+    // an empty file cannot be mapped, it has no contents anyway
+    file.m_size = static_cast<size_t>(status.st_size);
+    if (file.m_size > 0) {
+      void* data = mmap(nullptr, file.m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (data == MAP_FAILED) {
+        close(descriptor);
+        return cpp::fail("File <" + filepath.string() + "> could not be mapped into memory.");
+      }
+      madvise(data, file.m_size, MADV_SEQUENTIAL);
+      file.m_data = static_cast<const char*>(data);
+      file.m_isMapped = true;
+    }
+    close(descriptor);
+#else
+    std::ifstream input(filepath, std::ios::binary);
+    if (!input.is_open()) {
+      return cpp::fail(NotFoundError(filepath));
+    }
+    file.m_buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    file.m_data = file.m_buffer.data();
+    file.m_size = file.m_buffer.size();
+#endif
+
+    return file;
+  }
+
+  MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+  MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {  //
+
+    if (this != &other) {
+      Release();
+      m_isMapped = std::exchange(other.m_isMapped, false);
+      m_buffer = std::move(other.m_buffer);
+      m_size = std::exchange(other.m_size, 0);
+      m_data = m_isMapped ? other.m_data : m_buffer.data();
+      other.m_data = nullptr;
+    }
+    return *this;
+  }
+
+  MappedFile::~MappedFile() { Release(); }
+
+  void MappedFile::Release() {  //
+
+#ifdef NNN_HAS_MMAP
+    if (m_isMapped) {
+      munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_isMapped = false;
+    m_data = nullptr;
+    m_size = 0;
+  }
+}  // namespace nnn
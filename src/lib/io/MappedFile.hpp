@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "result.hpp"
+
+#include "IoError.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Read-only view of the whole contents of a file, memory-mapped on POSIX systems (the pages are loaded on
+   * first access and shared with the page cache) and read into memory elsewhere.
+   */
+  class MappedFile {
+   public:
+    /**
+     * @return the mapped file, or an error when the file does not exist or cannot be read.
+     */
+    static cpp::result<MappedFile, IoError> Open(const std::filesystem::path& filepath);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    inline const char* Data() const { return m_data; }
+    inline size_t GetSize() const { return m_size; }
+    inline std::string_view GetContents() const { return {m_data, m_size}; }
+
+   private:
+    MappedFile() = default;
+
+    void Release();
+
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_isMapped = false;
+    // the contents when the file cannot be mapped
+    std::string m_buffer;
+  };
+}  // namespace nnn
@@ -1,7 +1,15 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
 #include "CSVReader.hpp"
+#include "CachedReader.hpp"
+#include "IdxReader.hpp"
 #include "FloatMatrix.hpp"
 
 TEST_CASE("Valid file") {
@@ -52,10 +60,195 @@ TEST_CASE("Invalid file - corrupted data") {
   nnn::CSVReader reader;
   auto readResult = reader.Read("../../../../../src/lib/io/tests/testDataInvalid.csv");
   REQUIRE(readResult.has_error());
+  CHECK(readResult.error() == "Inconsistent column count at line <2>. Found <5> columns, but expected <4>!");
 }
 
 TEST_CASE("Invalid file - unknown file") {
   nnn::CSVReader reader;
   auto readResult = reader.Read("../../../../../src/lib/io/tests/UNKNOWN.csv");
   REQUIRE(readResult.has_error());
-}
\ No newline at end of file
+}
+
+TEST_CASE("Large file - parsed in chunks") {
+  // several chunks of a megabyte, Windows line ends, empty lines and trailing delimiters
+  const size_t rows = 40000;
+  const size_t cols = 7;
+  const auto path = std::filesystem::temp_directory_path() / "nnnCSVReaderLarge.csv";
+  {
+    std::ofstream output(path, std::ios::binary);
+    for (size_t row = 0; row < rows; ++row) {
+      for (size_t col = 0; col < cols; ++col) {
+        output << (col == 0 ? "" : ",") << row * 0.5f - col * 1.25e3f;
+      }
+      output << (row % 3 == 0 ? ",\r\n" : "\n") << (row % 1000 == 0 ? "\n" : "");
+    }
+  }
+
+  nnn::CSVReader reader;
+  auto readResult = reader.Read(path);
+  REQUIRE(readResult.has_value());
+
+  auto matrix = readResult.value();
+  REQUIRE(matrix->GetRowCount() == rows);
+  REQUIRE(matrix->GetColCount() == cols);
+  for (size_t row = 0; row < rows; row += 997) {
+    for (size_t col = 0; col < cols; ++col) {
+      CHECK_THAT((*matrix)(row, col), Catch::Matchers::WithinRel(row * 0.5f - col * 1.25e3f, 1e-5f));
+    }
+  }
+
+  // the error is reported for the first wrong cell of the file, with its line
+  {
+    std::ofstream output(path, std::ios::binary | std::ios::app);
+    output << "1,2,3,4,5,6,x7\n1,2\n";
+  }
+  readResult = reader.Read(path);
+  REQUIRE(readResult.has_error());
+  CHECK(readResult.error() == "Error while parsing float in file at line <" + std::to_string(rows + 1) +
+                                  ">, cell value: <x7>! Details: <Invalid argument>.");
+
+  std::filesystem::remove(path);
+}
+
+namespace {
+
+  /**
+   * @brief Counts how many times the files are actually parsed.
+   */
+  class CountingReader : public nnn::IReader {
+   public:
+    size_t readCount = 0;
+
+    CountingReader(char delimiter = ',') : m_reader(delimiter) {}
+
+    cpp::result<std::shared_ptr<nnn::FloatMatrix>, nnn::IoError> Read(std::filesystem::path filepath) override {
+      ++readCount;
+      return m_reader.Read(filepath);
+    }
+
+    uint64_t GetFingerprint() const override { return m_reader.GetFingerprint(); }
+
+   private:
+    nnn::CSVReader m_reader;
+  };
+}  // namespace
+
+TEST_CASE("Cached file - parsed once until the source changes") {
+  const auto path = std::filesystem::temp_directory_path() / "nnnCachedReader.csv";
+  const auto cachePath = nnn::CachedReader::GetCachePath(path);
+  std::filesystem::remove(cachePath);
+  {
+    std::ofstream output(path, std::ios::binary);
+    output << "1.5,2,3\n4,5,-6.25\n";
+  }
+
+  auto source = std::make_shared<CountingReader>();
+  nnn::CachedReader reader(source);
+
+  auto first = reader.Read(path);
+  REQUIRE(first.has_value());
+  REQUIRE(std::filesystem::exists(cachePath));
+
+  auto second = reader.Read(path);
+  REQUIRE(second.has_value());
+  CHECK(source->readCount == 1);
+  REQUIRE(second.value()->GetRowCount() == 2);
+  REQUIRE(second.value()->GetColCount() == 3);
+  CHECK(*second.value() == *first.value());
+
+  // touched, the same contents
+  std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(5));
+  REQUIRE(reader.Read(path).has_value());
+  CHECK(source->readCount == 1);
+
+  // the same size, different contents
+  {
+    std::ofstream output(path, std::ios::binary);
+    output << "1.5,2,3\n4,5,-7.25\n";
+  }
+  std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(10));
+  auto changed = reader.Read(path);
+  REQUIRE(changed.has_value());
+  CHECK(source->readCount == 2);
+  CHECK_THAT((*changed.value())(1, 2), Catch::Matchers::WithinAbs(-7.25f, 0.001));
+
+  // a broken cache is replaced
+  {
+    std::ofstream output(cachePath, std::ios::binary | std::ios::trunc);
+    output << "garbage";
+  }
+  REQUIRE(reader.Read(path).has_value());
+  CHECK(source->readCount == 3);
+  REQUIRE(reader.Read(path).has_value());
+  CHECK(source->readCount == 3);
+
+  // a reader with another delimiter parses the file itself instead of getting the matrix parsed with commas
+  auto semicolonSource = std::make_shared<CountingReader>(';');
+  nnn::CachedReader semicolonReader(semicolonSource);
+  CHECK(semicolonReader.Read(path).has_error());
+  CHECK(semicolonSource->readCount == 1);
+  REQUIRE(reader.Read(path).has_value());
+  CHECK(source->readCount == 3);
+
+  // errors of the source are passed through
+  CHECK(reader.Read(std::filesystem::temp_directory_path() / "nnnCachedReaderUNKNOWN.csv").has_error());
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(cachePath);
+}
+
+TEST_CASE("IDX files - images and labels") {
+  const auto imagesPath = std::filesystem::temp_directory_path() / "nnn-images-idx3-ubyte";
+  const auto labelsPath = std::filesystem::temp_directory_path() / "nnn-labels-idx1-ubyte";
+  {
+    // 2 images of 2x3 pixels, big-endian dimensions
+    std::ofstream images(imagesPath, std::ios::binary);
+    const unsigned char header[] = {0, 0, 8, 3, 0, 0, 0, 2, 0, 0, 0, 2, 0, 0, 0, 3};
+    const unsigned char pixels[] = {0, 64, 128, 255, 1, 2, 10, 20, 30, 40, 50, 60};
+    images.write(reinterpret_cast<const char*>(header), sizeof(header));
+    images.write(reinterpret_cast<const char*>(pixels), sizeof(pixels));
+
+    std::ofstream labels(labelsPath, std::ios::binary);
+    const unsigned char labelBytes[] = {0, 0, 8, 1, 0, 0, 0, 2, 7, 3};
+    labels.write(reinterpret_cast<const char*>(labelBytes), sizeof(labelBytes));
+  }
+
+  REQUIRE(nnn::IdxReader::IsIdxPath(imagesPath));
+  REQUIRE(!nnn::IdxReader::IsIdxPath("../data/fashion_mnist_train_vectors.csv"));
+
+  auto imagesResult = nnn::IdxReader(256.0f).Read(imagesPath);
+  REQUIRE(imagesResult.has_value());
+  auto imagesMatrix = imagesResult.value();
+  REQUIRE(imagesMatrix->GetRowCount() == 2);
+  REQUIRE(imagesMatrix->GetColCount() == 6);
+  CHECK((*imagesMatrix)(0, 1) == 0.25f);
+  CHECK((*imagesMatrix)(0, 3) == 255.0f / 256.0f);
+  CHECK((*imagesMatrix)(1, 5) == 60.0f / 256.0f);
+
+  auto labelsResult = nnn::IdxReader().Read(labelsPath);
+  REQUIRE(labelsResult.has_value());
+  REQUIRE(labelsResult.value()->GetRowCount() == 2);
+  REQUIRE(labelsResult.value()->GetColCount() == 1);
+  CHECK((*labelsResult.value())(0, 0) == 7.0f);
+  CHECK((*labelsResult.value())(1, 0) == 3.0f);
+
+  // truncated values
+  std::filesystem::resize_file(imagesPath, 20);
+  auto truncatedResult = nnn::IdxReader().Read(imagesPath);
+  REQUIRE(truncatedResult.has_error());
+  CHECK(truncatedResult.error().find("expected 12 values, found 4") != std::string::npos);
+
+  // dimensions whose product overflows
+  {
+    std::ofstream images(imagesPath, std::ios::binary | std::ios::trunc);
+    const unsigned char header[] = {
+        0, 0, 8, 4, 0, 0, 0, 1, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0};
+    images.write(reinterpret_cast<const char*>(header), sizeof(header));
+  }
+  auto overflowResult = nnn::IdxReader().Read(imagesPath);
+  REQUIRE(overflowResult.has_error());
+  CHECK(overflowResult.error().find("dimensions too large") != std::string::npos);
+
+  std::filesystem::remove(imagesPath);
+  std::filesystem::remove(labelsPath);
+}
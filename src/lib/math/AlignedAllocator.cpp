@@ -0,0 +1,57 @@
+#include "AlignedAllocator.hpp"
+
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+  inline bool IsHugeBuffer(size_t bytes) { return bytes >= nnn::HUGE_PAGE_SIZE && nnn::AreHugePagesAvailable(); }
+
+  inline size_t RoundUpToHugePage(size_t bytes) {
+    return (bytes + nnn::HUGE_PAGE_SIZE - 1) / nnn::HUGE_PAGE_SIZE * nnn::HUGE_PAGE_SIZE;
+  }
+}  // namespace
+
+namespace nnn {
+
+  bool AreHugePagesAvailable() {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // e.g. "always [madvise] never", the selected mode is in brackets
+    static const bool isAvailable = [] {
+      std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+      std::string modes;
+      return std::getline(file, modes) && modes.find("[never]") == std::string::npos;
+    }();
+    return isAvailable;
+#else
+    return false;
+#endif
+  }
+
+  void* AllocateStorage(size_t bytes) {  //
+
+    if (!IsHugeBuffer(bytes)) {
+      return ::operator new(bytes, std::align_val_t{STORAGE_ALIGNMENT});
+    }
+
+    const size_t size = RoundUpToHugePage(bytes);
+    void* ptr = ::operator new(size, std::align_val_t{HUGE_PAGE_SIZE});
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // Only a hint, the buffer works the same when transparent huge pages are disabled.
+    madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    return ptr;
+  }
+
+  void DeallocateStorage(void* ptr, size_t bytes) noexcept {
+    if (!IsHugeBuffer(bytes)) {
+      ::operator delete(ptr, std::align_val_t{STORAGE_ALIGNMENT});
+    } else {
+      ::operator delete(ptr, std::align_val_t{HUGE_PAGE_SIZE});
+    }
+  }
+}  // namespace nnn
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace nnn {
+
+  /**
+   * @brief Alignment of every FloatMatrix buffer, one cache line (and one AVX-512 register).
+   */
+  constexpr size_t STORAGE_ALIGNMENT = 64;
+
+  /**
+   * @brief When transparent huge pages are available (see `AreHugePagesAvailable`), buffers of at least this size are
+   * aligned to (and padded to a multiple of) the huge page size and the OS is asked to back them with huge pages, which
+   * cuts TLB misses when streaming through e.g. the dataset.
+   */
+  constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * @returns whether the OS can back buffers with transparent huge pages (always or on request), checked once.
+   * Otherwise large buffers get the same alignment as small ones, padding them would only waste memory.
+   */
+  bool AreHugePagesAvailable();
+
+  void* AllocateStorage(size_t bytes);
+  void DeallocateStorage(void* ptr, size_t bytes) noexcept;
+
+  /**
+   * @brief Standard allocator returning 64-byte aligned memory (huge-page backed for large buffers when available, see
+   * `HUGE_PAGE_SIZE`).
+   */
+  template <typename T>
+  class AlignedAllocator {
+   public:
+    using value_type = T;
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) { return static_cast<T*>(AllocateStorage(count * sizeof(T))); }
+
+    void deallocate(T* ptr, size_t count) noexcept { DeallocateStorage(ptr, count * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const noexcept {
+      return true;
+    }
+  };
+}  // namespace nnn
@@ -0,0 +1,56 @@
+#include "ByteMatrix.hpp"
+
+#include "FloatMatrixInvalidDimensionException.hpp"
+#include "Parallel.hpp"
+
+namespace {
+
+  /**
+   * @brief Widens and scales a contiguous range, a plain loop the compiler vectorizes (byte to float conversion and
+   * multiplication, several elements per instruction).
+   */
+  void ConvertRange(const uint8_t* source, size_t count, float scale, float* target) {
+    for (size_t i = 0; i < count; ++i) {
+      target[i] = static_cast<float>(source[i]) * scale;
+    }
+  }
+}  // namespace
+
+namespace nnn {
+
+  ByteMatrix::ByteMatrix(size_t rows, size_t cols, std::vector<uint8_t>&& data, float scale)
+      : m_data(std::move(data)), m_rows(rows), m_cols(cols), m_scale(scale) {  //
+
+    if (m_data.size() != rows * cols) {
+      throw FloatMatrixInvalidDimensionException("Data size does not match the dimensions of the matrix.");
+    }
+  }
+
+  void ByteMatrix::ConvertColumnsInto(FloatMatrix& destination, size_t begin, size_t end) const {  //
+
+    const size_t count = end - begin + 1;
+    destination.EnsureShape(m_rows, count, true);
+
+    // the columns are contiguous in both matrices, so is the whole range
+    const uint8_t* source = m_data.data() + begin * m_rows;
+    float* target = destination.Data();
+    const float scale = m_scale;
+    Parallel::ForChunks(m_rows * count, [=](size_t first, size_t last) {
+      ConvertRange(source + first, last - first, scale, target + first);
+    });
+  }
+
+  void ByteMatrix::ConvertColumnsInto(FloatMatrix& destination, std::span<const size_t> indices) const {  //
+
+    const size_t count = indices.size();
+    destination.EnsureShape(m_rows, count, true);
+
+    const uint8_t* source = m_data.data();
+    float* target = destination.Data();
+    const size_t rows = m_rows;
+    const float scale = m_scale;
+    Parallel::For(count, rows * count, [&](size_t i) {  //
+      ConvertRange(source + indices[i] * rows, rows, scale, target + i * rows);
+    });
+  }
+}  // namespace nnn
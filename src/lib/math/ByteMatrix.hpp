@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "FloatMatrix.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Compact read-only matrix of values that fit into a byte (e.g. pixels), one byte per element instead of four.
+   * Element (r, c) stands for the float `Data()[c * GetRowCount() + r] * GetScale()`, the storage is column-major, so
+   * that a column (a sample of a dataset) is contiguous.
+   *
+   * The values are converted to floats only when columns are copied into a FloatMatrix.
+   */
+  class ByteMatrix {
+   public:
+    /**
+     * @throws FloatMatrixInvalidDimensionException if the data does not have `rows * cols` elements
+     */
+    ByteMatrix(size_t rows, size_t cols, std::vector<uint8_t>&& data, float scale = 1.0f);
+
+    inline size_t GetRowCount() const { return m_rows; }
+    inline size_t GetColCount() const { return m_cols; }
+    inline size_t GetSize() const { return m_rows * m_cols; }
+    inline float GetScale() const { return m_scale; }
+    inline const uint8_t* Data() const { return m_data.data(); }
+
+    inline float operator()(size_t row, size_t col) const { return m_data[col * m_rows + row] * m_scale; }
+
+    /**
+     * @brief Converts columns [begin, end] into the destination (column-major, resized as needed).
+     */
+    void ConvertColumnsInto(FloatMatrix& destination, size_t begin, size_t end) const;
+
+    /**
+     * @brief Converts the columns with the given indices into the destination (column-major, resized as needed).
+     */
+    void ConvertColumnsInto(FloatMatrix& destination, std::span<const size_t> indices) const;
+
+   private:
+    std::vector<uint8_t> m_data;
+    size_t m_rows;
+    size_t m_cols;
+    float m_scale;
+  };
+}  // namespace nnn
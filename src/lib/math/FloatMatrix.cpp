@@ -1,6 +1,9 @@
 #include "FloatMatrix.hpp"
 #include "FloatMatrixInvalidDimensionException.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iomanip>
 #include <ios>
@@ -12,26 +15,35 @@
 namespace nnn {
 
   FloatMatrix::FloatMatrix(size_t rows, size_t cols)
-      : m_rows(rows), m_cols(cols), m_transposed(false), m_data(rows * cols) {}
+      : m_rows(rows), m_cols(cols), m_transposed(false), m_leadingDimension(cols), m_data(rows * cols) {}
 
-  FloatMatrix::FloatMatrix(size_t side) : m_rows(side), m_cols(side), m_transposed(false), m_data(side * side) {}
+  FloatMatrix::FloatMatrix(size_t side)
+      : m_rows(side), m_cols(side), m_transposed(false), m_leadingDimension(side), m_data(side * side) {}
 
   FloatMatrix::FloatMatrix(size_t rows, size_t cols, const std::vector<float>& data)
-      : m_rows(rows), m_cols(cols), m_transposed(false), m_data(data) {
+      : m_rows(rows), m_cols(cols), m_transposed(false), m_leadingDimension(cols), m_data(data.begin(), data.end()) {
     if (data.size() != rows * cols) {
       throw FloatMatrixInvalidDimensionException("Data size must match matrix dimensions");
     }
   }
 
   FloatMatrix::FloatMatrix(size_t rows, size_t cols, std::vector<float>&& data)
-      : m_rows(rows), m_cols(cols), m_transposed(false), m_data(std::move(data)) {
-    if (m_data.size() != rows * cols) {
+      : m_rows(rows), m_cols(cols), m_transposed(false), m_leadingDimension(cols), m_data(data.begin(), data.end()) {
+    if (GetStorageSize() != rows * cols) {
       throw FloatMatrixInvalidDimensionException("Data size must match matrix dimensions");
     }
   }
 
+  FloatMatrix::FloatMatrix(FloatMatrixView view) : FloatMatrix(0, 0) {
+    if (view.GetColCount() == 0) {
+      EnsureShape(view.GetRowCount(), 0, view.IsTransposed());
+    } else {
+      GatherColumnsInto(*this, view, 0, view.GetColCount() - 1);
+    }
+  }
+
   FloatMatrix::FloatMatrix(size_t rows, size_t cols, float initialValue)
-      : m_rows(rows), m_cols(cols), m_transposed(false), m_data(rows * cols, initialValue) {}
+      : m_rows(rows), m_cols(cols), m_transposed(false), m_leadingDimension(cols), m_data(rows * cols, initialValue) {}
 
   std::optional<FloatMatrix> FloatMatrix::Create(size_t rows, size_t cols, const std::vector<float>& data) {
     if (data.size() != rows * cols) {
@@ -63,6 +75,27 @@ namespace nnn {
     return result;
   }
 
+  FloatMatrix FloatMatrix::ZeroesPadded(size_t rows, size_t cols) {
+    FloatMatrix result(0, 0);
+    result.m_leadingDimension = GetPaddedLeadingDimension(cols);
+    result.m_data.resize(rows * result.m_leadingDimension);
+    result.m_rows = rows;
+    result.m_cols = cols;
+    return result;
+  }
+
+  size_t FloatMatrix::GetPaddedLeadingDimension(size_t cols) {  //
+
+    constexpr size_t CACHE_LINE_FLOATS = STORAGE_ALIGNMENT / sizeof(float);
+    constexpr size_t CRITICAL_STRIDE_FLOATS = 1024 / sizeof(float);
+
+    size_t leadingDimension = (cols + CACHE_LINE_FLOATS - 1) / CACHE_LINE_FLOATS * CACHE_LINE_FLOATS;
+    if (leadingDimension > 0 && leadingDimension % CRITICAL_STRIDE_FLOATS == 0) {
+      leadingDimension += CACHE_LINE_FLOATS;
+    }
+    return leadingDimension;
+  }
+
   std::optional<float> FloatMatrix::At(size_t row, size_t col) const {  //
 
     if (row >= m_rows || col >= m_cols) {
@@ -84,129 +117,443 @@ namespace nnn {
     std::swap(m_rows, m_cols);
   }
 
-  float* FloatMatrix::Data() { return m_data.data(); }
+  FloatMatrix::FloatMatrix(const FloatMatrix& other)
+      : m_data(other.m_externalData == nullptr ? other.m_data
+                                               : Storage(other.Data(), other.Data() + other.GetStorageSize())),
+        m_rows(other.m_rows),
+        m_cols(other.m_cols),
+        m_transposed(other.m_transposed),
+        m_leadingDimension(other.m_leadingDimension) {}
 
-  const float* FloatMatrix::Data() const { return m_data.data(); }
+  FloatMatrix::FloatMatrix(FloatMatrix&& other) noexcept
+      : m_data(std::move(other.m_data)),
+        m_externalData(std::exchange(other.m_externalData, nullptr)),
+        m_rows(std::exchange(other.m_rows, 0)),
+        m_cols(std::exchange(other.m_cols, 0)),
+        m_transposed(std::exchange(other.m_transposed, false)),
+        m_leadingDimension(std::exchange(other.m_leadingDimension, 0)) {}
 
-  FloatMatrix FloatMatrix::GetColumns(size_t begin, size_t end) const {
-    auto result = FloatMatrix(GetRowCount(), end - begin + 1);
-    for (size_t r = 0; r < GetRowCount(); ++r) {
-      for (size_t c = begin; c <= end; ++c) {
-        result(r, c - begin) = (*this)(r, c);
-      }
+  FloatMatrix& FloatMatrix::operator=(const FloatMatrix& other) {  //
+
+    if (this == &other) {
+      return *this;
     }
 
-    return result;
+    if (m_externalData != nullptr) {
+      CopyValuesIntoExternalStorage(other);
+      return *this;
+    }
+
+    if (other.m_externalData == nullptr) {
+      m_data = other.m_data;
+    } else {
+      m_data.assign(other.Data(), other.Data() + other.GetStorageSize());
+    }
+    m_rows = other.m_rows;
+    m_cols = other.m_cols;
+    m_transposed = other.m_transposed;
+    m_leadingDimension = other.m_leadingDimension;
+    return *this;
   }
 
-  FloatMatrix FloatMatrix::GetColumns(const std::vector<size_t>& indices) const {  //
+  FloatMatrix& FloatMatrix::operator=(FloatMatrix&& other) {  //
 
-    if (indices.size() == 0) {
-      return FloatMatrix(0, 0);
+    if (this == &other) {
+      return *this;
     }
 
-    auto result = FloatMatrix(GetRowCount(), indices.size());
-
-    for (size_t r = 0; r < GetRowCount(); ++r) {
-      for (size_t i = 0; i < indices.size(); ++i) {
-        size_t c = indices[i];
-        result(r, i) = (*this)(r, c);
-      }
+    if (m_externalData != nullptr) {
+      CopyValuesIntoExternalStorage(other);
+      return *this;
     }
 
-    return result;
+    m_data = std::move(other.m_data);
+    m_externalData = std::exchange(other.m_externalData, nullptr);
+    m_rows = std::exchange(other.m_rows, 0);
+    m_cols = std::exchange(other.m_cols, 0);
+    m_transposed = std::exchange(other.m_transposed, false);
+    m_leadingDimension = std::exchange(other.m_leadingDimension, 0);
+    return *this;
   }
 
-  FloatMatrix FloatMatrix::operator+(const FloatMatrix& other) const {
-    if (m_rows != other.m_rows) {
-      throw FloatMatrixInvalidDimensionException("Cannot add matrices when row count does not match.");
-    } else if (m_cols != other.m_cols) {
-      throw FloatMatrixInvalidDimensionException("Cannot add matrices when column count does not match.");
+  void FloatMatrix::CopyValuesIntoExternalStorage(const FloatMatrix& other) {  //
+
+    if (m_rows != other.m_rows || m_cols != other.m_cols) {
+      throw FloatMatrixInvalidDimensionException(
+          "Cannot assign a matrix of different size to a matrix with external storage.");
+    }
+
+    if (HaveSameContiguousLayout(*this, other)) {
+      std::copy_n(other.Data(), GetSize(), Data());
+    } else {
+      for (size_t r = 0; r < m_rows; ++r) {
+        for (size_t c = 0; c < m_cols; ++c) {
+          (*this)(r, c) = other(r, c);
+        }
+      }
     }
+  }
 
-    FloatMatrix result(m_rows, m_cols);
+  void FloatMatrix::MoveToExternalStorage(float* data) {  //
 
-    for (size_t row = 0; row < m_rows; ++row) {
-      for (size_t col = 0; col < m_cols; ++col) {
-        result(row, col) = (*this)(row, col) + other(row, col);
+    for (size_t r = 0; r < m_rows; ++r) {
+      for (size_t c = 0; c < m_cols; ++c) {
+        data[r * m_cols + c] = (*this)(r, c);
       }
     }
-    return result;
+
+    Storage().swap(m_data);
+    m_externalData = data;
+    m_transposed = false;
+    m_leadingDimension = m_cols;
   }
 
-  FloatMatrix& FloatMatrix::operator+=(const FloatMatrix& other) {
-    if (m_rows != other.m_rows) {
-      throw FloatMatrixInvalidDimensionException("Cannot add matrices when row count does not match.");
-    } else if (m_cols != other.m_cols) {
-      throw FloatMatrixInvalidDimensionException("Cannot add matrices when column count does not match.");
+  void FloatMatrix::ResizeStorage(size_t size) {  //
+
+    if (m_externalData == nullptr) {
+      m_data.resize(size);
+    } else if (size != GetSize()) {
+      throw FloatMatrixInvalidDimensionException("Cannot resize a matrix with external storage.");
     }
+  }
 
-    for (size_t row = 0; row < m_rows; ++row) {
-      for (size_t col = 0; col < m_cols; ++col) {
-        (*this)(row, col) = (*this)(row, col) + other(row, col);
-      }
+  void FloatMatrix::EnsureShape(size_t rows, size_t cols) {  //
+
+    if (m_rows == rows && m_cols == cols) {
+      return;
     }
 
-    return *this;
+    ResizeStorage(rows * cols);
+    m_rows = rows;
+    m_cols = cols;
+    m_transposed = false;
+    m_leadingDimension = cols;
   }
 
-  FloatMatrix FloatMatrix::operator-(const FloatMatrix& other) const {
-    if (m_rows != other.m_rows) {
-      throw FloatMatrixInvalidDimensionException("Cannot subtract matrices when row count does not match.");
-    } else if (m_cols != other.m_cols) {
-      throw FloatMatrixInvalidDimensionException("Cannot subtract matrices when column count does not match.");
+  void FloatMatrix::EnsureShape(size_t rows, size_t cols, bool transposed) {  //
+
+    if (m_rows == rows && m_cols == cols && m_transposed == transposed) {
+      return;
     }
 
-    FloatMatrix result(m_rows, m_cols);
+    ResizeStorage(rows * cols);
+    m_rows = rows;
+    m_cols = cols;
+    m_transposed = transposed;
+    m_leadingDimension = transposed ? rows : cols;
+  }
 
-    for (size_t row = 0; row < m_rows; ++row) {
-      for (size_t col = 0; col < m_cols; ++col) {
-        result(row, col) = (*this)(row, col) - other(row, col);
-      }
+  void FloatMatrix::CheckSameDimensions(FloatMatrixView a, FloatMatrixView b, const char* operation) {
+    if (a.GetRowCount() != b.GetRowCount()) {
+      throw FloatMatrixInvalidDimensionException(
+          ("Cannot " + std::string(operation) + " when row count does not match.").c_str());
+    } else if (a.GetColCount() != b.GetColCount()) {
+      throw FloatMatrixInvalidDimensionException(
+          ("Cannot " + std::string(operation) + " when column count does not match.").c_str());
     }
+  }
+
+  FloatMatrix FloatMatrix::GetColumns(size_t begin, size_t end) const {
+    FloatMatrix result(0, 0);
+    GatherColumnsInto(result, *this, begin, end);
     return result;
   }
 
-  FloatMatrix& FloatMatrix::operator-=(const FloatMatrix& other) {
-    if (m_rows != other.m_rows) {
-      throw FloatMatrixInvalidDimensionException("Cannot subtract matrices when row count does not match.");
-    } else if (m_cols != other.m_cols) {
-      throw FloatMatrixInvalidDimensionException("Cannot subtract matrices when column count does not match.");
+  FloatMatrix FloatMatrix::GetColumns(const std::vector<size_t>& indices) const {  //
+
+    FloatMatrix result(0, 0);
+    if (indices.size() == 0) {
+      return result;
     }
 
-    for (size_t row = 0; row < m_rows; ++row) {
-      for (size_t col = 0; col < m_cols; ++col) {
-        (*this)(row, col) = (*this)(row, col) - other(row, col);
-      }
+    GatherColumnsInto(result, *this, indices);
+    return result;
+  }
+
+  void FloatMatrix::GatherColumnsInto(FloatMatrix& destination, FloatMatrixView matrix, size_t begin, size_t end) {
+    CheckNotAliased(destination, matrix);
+
+    const size_t rows = matrix.GetRowCount();
+    const size_t count = end - begin + 1;
+    destination.EnsureShape(rows, count, matrix.IsTransposed());
+
+    const float* source = matrix.Data();
+    const size_t ld = matrix.GetLeadingDimension();
+    float* target = destination.Data();
+    if (matrix.IsTransposed() && matrix.IsContiguous()) {
+      // columns are contiguous in the storage, so is the whole range
+      source += begin * rows;
+      Parallel::ForChunks(rows * count, [=](size_t first, size_t last) {
+        std::copy(source + first, source + last, target + first);
+      });
+    } else if (matrix.IsTransposed()) {
+      Parallel::For(count, rows * count, [=](size_t i) {  //
+        std::copy_n(source + (begin + i) * ld, rows, target + i * rows);
+      });
+    } else {
+      Parallel::For(rows, rows * count, [=](size_t r) {  //
+        std::copy_n(source + r * ld + begin, count, target + r * count);
+      });
     }
+  }
 
-    return *this;
+  void FloatMatrix::GatherColumnsInto(
+      FloatMatrix& destination, FloatMatrixView matrix, const std::vector<size_t>& indices) {
+    GatherColumnsInto(destination, matrix, std::span<const size_t>(indices));
+  }
+
+  void FloatMatrix::GatherColumnsInto(
+      FloatMatrix& destination, FloatMatrixView matrix, std::span<const size_t> indices) {  //
+
+    CheckNotAliased(destination, matrix);
+
+    const size_t rows = matrix.GetRowCount();
+    const size_t count = indices.size();
+    destination.EnsureShape(rows, count, matrix.IsTransposed());
+
+    const float* source = matrix.Data();
+    const size_t ld = matrix.GetLeadingDimension();
+    float* target = destination.Data();
+    if (matrix.IsTransposed()) {
+      Parallel::For(count, rows * count, [&](size_t i) {  //
+        std::copy_n(source + indices[i] * ld, rows, target + i * rows);
+      });
+    } else {
+      Parallel::For(rows, rows * count, [&](size_t r) {
+        const float* row = source + r * ld;
+        float* targetRow = target + r * count;
+        for (size_t i = 0; i < count; ++i) {
+          targetRow[i] = row[indices[i]];
+        }
+      });
+    }
   }
 
-  FloatMatrix FloatMatrix::operator*(const FloatMatrix& other) const {  //
+  void FloatMatrix::AddInto(
+      FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha, float beta) {  //
+
+    CheckSameDimensions(a, b, "add matrices");
+    CheckElementWiseAliasing(destination, a);
+    CheckElementWiseAliasing(destination, b);
+    destination.EnsureShape(a.GetRowCount(), a.GetColCount());
+
+    if (HaveSameContiguousLayout(destination, a) && HaveSameContiguousLayout(destination, b)) {
+      float* target = destination.Data();
+      const float* x = a.Data();
+      const float* y = b.Data();
+      Parallel::ForChunks(destination.GetStorageSize(), [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          target[i] = alpha * x[i] + beta * y[i];
+        }
+      });
+    } else {
+      Parallel::For(a.GetRowCount(), a.GetSize(), [&](size_t row) {
+        for (size_t col = 0; col < a.GetColCount(); ++col) {
+          destination(row, col) = alpha * a(row, col) + beta * b(row, col);
+        }
+      });
+    }
+  }
 
-    if (m_cols != other.m_rows) {
-      throw FloatMatrixInvalidDimensionException(
-          "Cannot multiply matrices when column count does not match row count.");
+  void FloatMatrix::HadamardInto(
+      FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha, float beta) {  //
+
+    CheckSameDimensions(a, b, "compute hadamard product for matrices");
+    if (beta != 0.0f) {
+      CheckSameDimensions(destination, a, "accumulate hadamard product");
+    }
+    CheckElementWiseAliasing(destination, a);
+    CheckElementWiseAliasing(destination, b);
+    destination.EnsureShape(a.GetRowCount(), a.GetColCount());
+
+    if (HaveSameContiguousLayout(destination, a) && HaveSameContiguousLayout(destination, b)) {
+      float* target = destination.Data();
+      const float* x = a.Data();
+      const float* y = b.Data();
+      Parallel::ForChunks(destination.GetStorageSize(), [=](size_t begin, size_t end) {
+        if (beta == 0.0f) {
+          for (size_t i = begin; i < end; ++i) {
+            target[i] = alpha * (x[i] * y[i]);
+          }
+        } else {
+          for (size_t i = begin; i < end; ++i) {
+            target[i] = alpha * (x[i] * y[i]) + beta * target[i];
+          }
+        }
+      });
+    } else {
+      Parallel::For(a.GetRowCount(), a.GetSize(), [&](size_t row) {
+        for (size_t col = 0; col < a.GetColCount(); ++col) {
+          float& target = destination(row, col);
+          target = alpha * (a(row, col) * b(row, col)) + (beta == 0.0f ? 0.0f : beta * target);
+        }
+      });
     }
+  }
 
-#ifdef _OPENMP
-    FloatMatrix result = FloatMatrix(m_rows, other.m_cols);
-#pragma omp parallel for
-    for (int i = 0; i < m_rows; ++i) {
-      for (int j = 0; j < other.m_cols; ++j) {
+  void FloatMatrix::SumColumnsInto(FloatMatrix& destination, FloatMatrixView matrix, float alpha, float beta) {
+    CheckNotAliased(destination, matrix);
+
+    const size_t rows = matrix.GetRowCount();
+    const size_t cols = matrix.GetColCount();
+    if (beta != 0.0f && (destination.m_rows != rows || destination.m_cols != 1)) {
+      throw FloatMatrixInvalidDimensionException("Cannot accumulate column sum into a matrix of different size.");
+    }
+    destination.EnsureShape(rows, 1);
+
+    float* target = destination.Data();
+    const size_t targetStride = destination.GetRowStride();
+    const float* source = matrix.Data();
+    const size_t ld = matrix.GetLeadingDimension();
+
+    // Every thread owns whole rows of the result, so each sum is computed in the same order regardless of the number
+    // of threads.
+    if (!matrix.IsTransposed()) {
+      Parallel::For(rows, rows * cols, [=](size_t r) {
         float sum = 0.0f;
-        for (int k = 0; k < m_cols; ++k) {
-          sum += (*this)(i, k) * other(k, j);
+        for (size_t c = 0; c < cols; ++c) {
+          sum += source[r * ld + c];
         }
-        result(i, j) = sum;
-      }
+        float& value = target[r * targetStride];
+        value = alpha * sum + (beta == 0.0f ? 0.0f : beta * value);
+      });
+    } else if (beta == 0.0f && targetStride == 1) {
+      // the columns are contiguous, accumulate them directly into the destination, a cache line of rows per task
+      constexpr size_t ROW_BLOCK = 16;
+      Parallel::For((rows + ROW_BLOCK - 1) / ROW_BLOCK, rows * cols, [=](size_t block) {
+        const size_t rowBegin = block * ROW_BLOCK;
+        const size_t rowEnd = std::min(rowBegin + ROW_BLOCK, rows);
+        std::fill(target + rowBegin, target + rowEnd, 0.0f);
+        for (size_t c = 0; c < cols; ++c) {
+          for (size_t r = rowBegin; r < rowEnd; ++r) {
+            target[r] += source[c * ld + r];
+          }
+        }
+        if (alpha != 1.0f) {
+          for (size_t r = rowBegin; r < rowEnd; ++r) {
+            target[r] *= alpha;
+          }
+        }
+      });
+    } else {
+      Parallel::For(rows, rows * cols, [=](size_t r) {
+        float sum = 0.0f;
+        for (size_t c = 0; c < cols; ++c) {
+          sum += source[c * ld + r];
+        }
+        float& value = target[r * targetStride];
+        value = alpha * sum + (beta == 0.0f ? 0.0f : beta * value);
+      });
     }
+  }
+
+  void FloatMatrix::MultiplyInto(
+      FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha, float beta) {  //
+
+    if (a.GetColCount() != b.GetRowCount()) {
+      throw FloatMatrixInvalidDimensionException(
+          "Cannot multiply matrices when column count does not match row count.");
+    }
+
+    PrepareProductDestination(destination, a, b, a.GetRowCount(), b.GetColCount(), beta);
+    Gemm::Multiply(a.GetRowCount(), b.GetColCount(), a.GetColCount(), a.AsOperand(), b.AsOperand(),
+        destination.AsOutput(), {.alpha = alpha, .beta = beta});
+  }
+
+  void FloatMatrix::MultiplyTransAInto(
+      FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha, float beta) {  //
+
+    if (a.GetRowCount() != b.GetRowCount()) {
+      throw FloatMatrixInvalidDimensionException(
+          "Cannot multiply transposed matrix when row counts of both matrices do not match.");
+    }
+
+    PrepareProductDestination(destination, a, b, a.GetColCount(), b.GetColCount(), beta);
+    Gemm::Multiply(a.GetColCount(), b.GetColCount(), a.GetRowCount(), Gemm::Transposed(a.AsOperand()), b.AsOperand(),
+        destination.AsOutput(), {.alpha = alpha, .beta = beta});
+  }
+
+  void FloatMatrix::MultiplyTransBInto(
+      FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha, float beta) {  //
+
+    if (a.GetColCount() != b.GetColCount()) {
+      throw FloatMatrixInvalidDimensionException(
+          "Cannot multiply by transposed matrix when column counts of both matrices do not match.");
+    }
+
+    PrepareProductDestination(destination, a, b, a.GetRowCount(), b.GetRowCount(), beta);
+    Gemm::Multiply(a.GetRowCount(), b.GetRowCount(), a.GetColCount(), a.AsOperand(), Gemm::Transposed(b.AsOperand()),
+        destination.AsOutput(), {.alpha = alpha, .beta = beta});
+  }
+
+  void FloatMatrix::PrepareProductDestination(
+      FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, size_t rows, size_t cols, float beta) {  //
+
+    CheckNotAliased(destination, a);
+    CheckNotAliased(destination, b);
+
+    if (beta != 0.0f && (destination.m_rows != rows || destination.m_cols != cols)) {
+      throw FloatMatrixInvalidDimensionException("Cannot accumulate matrix product into a matrix of different size.");
+    }
+    destination.EnsureShape(rows, cols);
+  }
+
+  bool FloatMatrix::HaveSameContiguousLayout(FloatMatrixView a, FloatMatrixView b) {
+    return a.IsTransposed() == b.IsTransposed() && a.IsContiguous() && b.IsContiguous();
+  }
+
+  bool FloatMatrix::Overlaps(const FloatMatrix& destination, FloatMatrixView source) {
+    const float* begin = destination.Data();
+    const float* end = begin + destination.GetStorageSize();
+    return source.GetSize() != 0 && source.Data() >= begin && source.Data() < end;
+  }
+
+  void FloatMatrix::CheckNotAliased(const FloatMatrix& destination, FloatMatrixView source) {
+    if (Overlaps(destination, source)) {
+      throw FloatMatrixInvalidDimensionException("The destination of the operation cannot be one of its operands.");
+    }
+  }
+
+  void FloatMatrix::CheckElementWiseAliasing(const FloatMatrix& destination, FloatMatrixView source) {  //
+
+    // Element-wise operations may overwrite their operand, as long as every element maps onto itself.
+    if (Overlaps(destination, source) &&
+        (source.Data() != destination.Data() || source.IsTransposed() != destination.m_transposed ||
+            source.GetLeadingDimension() != destination.m_leadingDimension ||
+            source.GetRowCount() != destination.m_rows || source.GetColCount() != destination.m_cols)) {
+      throw FloatMatrixInvalidDimensionException(
+          "The destination of the operation can only be an operand with exactly the same layout.");
+    }
+  }
+
+  FloatMatrix FloatMatrix::operator+(const FloatMatrix& other) const {
+    FloatMatrix result(0, 0);
+    AddInto(result, *this, other);
+    return result;
+  }
+
+  FloatMatrix& FloatMatrix::operator+=(const FloatMatrix& other) {
+    AddInto(*this, *this, other);
+    return *this;
+  }
 
+  FloatMatrix FloatMatrix::operator-(const FloatMatrix& other) const {
+    CheckSameDimensions(*this, other, "subtract matrices");
+    FloatMatrix result(0, 0);
+    AddInto(result, *this, other, 1.0f, -1.0f);
+    return result;
+  }
+
+  FloatMatrix& FloatMatrix::operator-=(const FloatMatrix& other) {
+    CheckSameDimensions(*this, other, "subtract matrices");
+    AddInto(*this, *this, other, 1.0f, -1.0f);
+    return *this;
+  }
+
+  FloatMatrix FloatMatrix::operator*(const FloatMatrix& other) const {
+    FloatMatrix result(0, 0);
+    MultiplyInto(result, *this, other);
     return result;
-#else
-    return this->MultiplySerial(other);
-#endif
   }
 
   FloatMatrix FloatMatrix::MultiplySerial(const FloatMatrix& other) const {  //
@@ -217,16 +564,20 @@ namespace nnn {
     }
 
     FloatMatrix result = FloatMatrix(m_rows, other.m_cols);
+    Gemm::Multiply(
+        m_rows, other.m_cols, m_cols, AsOperand(), other.AsOperand(), result.AsOutput(), {.isParallel = false});
+    return result;
+  }
 
-    for (size_t i = 0; i < m_rows; ++i) {
-      for (size_t k = 0; k < m_cols; ++k) {
-        float a = (*this)(i, k);
-        for (size_t j = 0; j < other.m_cols; ++j) {
-          result(i, j) += a * other(k, j);
-        }
-      }
-    }
+  FloatMatrix FloatMatrix::MultiplyTransA(const FloatMatrix& other) const {
+    FloatMatrix result(0, 0);
+    MultiplyTransAInto(result, *this, other);
+    return result;
+  }
 
+  FloatMatrix FloatMatrix::MultiplyTransB(const FloatMatrix& other) const {
+    FloatMatrix result(0, 0);
+    MultiplyTransBInto(result, *this, other);
     return result;
   }
 
@@ -241,9 +592,19 @@ namespace nnn {
     }
 
     const float TOLERANCE = 1e-6f;
-    for (size_t i = 0; i < m_data.size(); ++i) {
-      if (std::abs(m_data[i] - other.m_data[i]) >= TOLERANCE) {
-        return false;
+    if (HaveSameContiguousLayout(*this, other)) {
+      for (size_t i = 0; i < GetStorageSize(); ++i) {
+        if (std::abs(Data()[i] - other.Data()[i]) >= TOLERANCE) {
+          return false;
+        }
+      }
+    } else {
+      for (size_t r = 0; r < m_rows; ++r) {
+        for (size_t c = 0; c < m_cols; ++c) {
+          if (std::abs((*this)(r, c) - other(r, c)) >= TOLERANCE) {
+            return false;
+          }
+        }
       }
     }
 
@@ -251,34 +612,14 @@ namespace nnn {
   }
 
   FloatMatrix FloatMatrix::operator*(float scalar) const {
-    FloatMatrix result(m_rows, m_cols);
-    for (size_t i = 0; i < m_data.size(); ++i) {
-      result.m_data[i] = m_data[i] * scalar;
-    }
-    return result;
+    return Map([scalar](float x) { return x * scalar; });
   }
 
   FloatMatrix& FloatMatrix::operator*=(float scalar) {
-    for (auto& v : m_data) {
-      v *= scalar;
-    }
+    MapInPlace([scalar](float x) { return x * scalar; });
     return *this;
   }
 
-  FloatMatrix FloatMatrix::Map(const std::function<float(float)>& func) const {
-    FloatMatrix result(m_rows, m_cols);
-    for (size_t i = 0; i < m_data.size(); ++i) {
-      result.m_data[i] = func(m_data[i]);
-    }
-    return result;
-  }
-
-  void FloatMatrix::MapInPlace(const std::function<float(float)>& func) {
-    for (size_t i = 0; i < m_data.size(); ++i) {
-      m_data[i] = func(m_data[i]);
-    }
-  }
-
   void FloatMatrix::AddToAllCols(const FloatMatrix& vector) {
     if (vector.m_cols != 1) {
       throw FloatMatrixInvalidDimensionException("Invalid vector for addition: the matrix is not a column vector.");
@@ -289,40 +630,35 @@ namespace nnn {
           "Invalid vector for addition: the vector height must match matrix row count.");
     }
 
-    for (size_t r = 0; r < m_rows; ++r) {
-      for (size_t c = 0; c < m_cols; ++c) {
-        (*this)(r, c) += vector(r, 0);
-      }
+    float* data = Data();
+    const size_t ld = m_leadingDimension;
+    if (!m_transposed) {
+      Parallel::For(m_rows, GetSize(), [&](size_t r) {
+        const float value = vector(r, 0);
+        float* row = data + r * ld;
+        for (size_t c = 0; c < m_cols; ++c) {
+          row[c] += value;
+        }
+      });
+    } else {
+      Parallel::For(m_cols, GetSize(), [&](size_t c) {
+        float* column = data + c * ld;
+        for (size_t r = 0; r < m_rows; ++r) {
+          column[r] += vector(r, 0);
+        }
+      });
     }
   }
 
-  FloatMatrix FloatMatrix::Hadamard(const FloatMatrix& other) const {  //
-
-    if (m_rows != other.m_rows) {
-      throw FloatMatrixInvalidDimensionException(
-          "Cannot compute hadamard product for matrices when row count does not match.");
-    } else if (m_cols != other.m_cols) {
-      throw FloatMatrixInvalidDimensionException(
-          "Cannot compute hadamard product for matrices when column count does not match.");
-    }
-
-    FloatMatrix result(m_rows, m_cols);
-    for (size_t i = 0; i < m_rows; ++i) {
-      for (size_t j = 0; j < m_cols; ++j) {
-        result(i, j) = (*this)(i, j) * other(i, j);
-      }
-    }
+  FloatMatrix FloatMatrix::Hadamard(const FloatMatrix& other) const {
+    FloatMatrix result(0, 0);
+    HadamardInto(result, *this, other);
     return result;
   }
 
-  FloatMatrix FloatMatrix::SumColumns(const FloatMatrix& matrix) {  //
-
-    auto result = nnn::FloatMatrix(matrix.GetRowCount(), 1);
-    for (size_t i = 0; i < matrix.GetRowCount(); i++) {
-      for (size_t j = 0; j < matrix.GetColCount(); j++) {
-        result(i, 0) += matrix(i, j);
-      }
-    }
+  FloatMatrix FloatMatrix::SumColumns(const FloatMatrix& matrix) {
+    FloatMatrix result(0, 0);
+    SumColumnsInto(result, matrix);
     return result;
   }
 
@@ -1,50 +1,203 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <optional>
+#include <span>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "AlignedAllocator.hpp"
+#include "FloatMatrixView.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+
 namespace nnn {
 
+  template <typename Derived>
+  class MatrixExpression;
+
   class FloatMatrix {
+   public:
+    using Storage = std::vector<float, AlignedAllocator<float>>;
+
    private:
-    std::vector<float> m_data;
+    Storage m_data;
+    // set when the values live in a buffer owned by someone else, see `MoveToExternalStorage`
+    float* m_externalData = nullptr;
     size_t m_rows;
     size_t m_cols;
     bool m_transposed = false;
+    size_t m_leadingDimension = 0;
     static const unsigned int m_seed = 42;
 
    public:
     FloatMatrix(size_t side);
     FloatMatrix(size_t rows, size_t cols);
     FloatMatrix(size_t rows, size_t cols, const std::vector<float>& data);
+
+    /**
+     * @note The data is copied into the aligned storage.
+     */
     FloatMatrix(size_t rows, size_t cols, std::vector<float>&& data);
 
+    /**
+     * @brief Copies the viewed elements into a new contiguous matrix with the layout of the view.
+     */
+    explicit FloatMatrix(FloatMatrixView view);
+
+    // Copies of a matrix with external storage own their storage, moves take the buffer over (nothing is allocated)
+    // and leave an empty matrix behind. Assigning to a matrix with external storage copies the values into the buffer,
+    // the shape has to match.
+
+    FloatMatrix(const FloatMatrix& other);
+    FloatMatrix(FloatMatrix&& other) noexcept;
+    FloatMatrix& operator=(const FloatMatrix& other);
+    FloatMatrix& operator=(FloatMatrix&& other);
+
+    /**
+     * @brief Materializes a lazy element-wise expression (see MatrixExpression.hpp) in a single pass.
+     */
+    template <typename Expression>
+    FloatMatrix(const MatrixExpression<Expression>& expression);
+
+    template <typename Expression>
+    FloatMatrix& operator=(const MatrixExpression<Expression>& expression);
+
     static std::optional<FloatMatrix> Create(size_t rows, size_t cols, const std::vector<float>& data);
     static FloatMatrix Ones(size_t rows, size_t cols);
     static FloatMatrix Zeroes(size_t rows, size_t cols);
     static FloatMatrix Identity(size_t side);
     static FloatMatrix Random(size_t rows, size_t cols, float min = 0.0f, float max = 1.0f);
 
+    /**
+     * @brief Creates a zero matrix whose rows start at cache line boundaries, see `GetPaddedLeadingDimension`.
+     */
+    static FloatMatrix ZeroesPadded(size_t rows, size_t cols);
+
+    /**
+     * @brief Rounds the row length up to a whole number of cache lines and adds one more cache line when the stride
+     * would be a multiple of 1 KiB (consecutive rows would then compete for the same few L1 sets).
+     */
+    static size_t GetPaddedLeadingDimension(size_t cols);
+
     inline size_t GetSize() const { return m_rows * m_cols; }
     inline size_t GetRowCount() const { return m_rows; }
     inline size_t GetColCount() const { return m_cols; }
     inline bool IsTransposed() const { return m_transposed; }
 
+    /**
+     * @brief Distance (in elements) between the starts of two consecutive rows of the storage (columns of a transposed
+     * matrix). Equals the row length unless the matrix is padded.
+     */
+    inline size_t GetLeadingDimension() const { return m_leadingDimension; }
+    inline bool IsContiguous() const { return m_leadingDimension == GetLineLength(); }
+
+    /**
+     * @brief Distance (in elements) between two consecutive rows/columns of the matrix in the underlying storage.
+     */
+    inline size_t GetRowStride() const { return m_transposed ? 1 : m_leadingDimension; }
+    inline size_t GetColStride() const { return m_transposed ? m_leadingDimension : 1; }
+
     void Transpose();
-    inline float& operator()(size_t row, size_t col) { return m_data[ComputeIndex(row, col)]; }
-    inline const float& operator()(size_t row, size_t col) const { return m_data[ComputeIndex(row, col)]; }
+    inline float& operator()(size_t row, size_t col) { return Data()[ComputeIndex(row, col)]; }
+    inline const float& operator()(size_t row, size_t col) const { return Data()[ComputeIndex(row, col)]; }
 
     std::optional<float> At(size_t row, size_t col) const;
     bool Set(size_t row, size_t col, float value);
 
-    float* Data();
-    const float* Data() const;
+    /**
+     * @brief The storage is 64-byte aligned, padded matrices keep every row (column if transposed) aligned as well.
+     * Element (r, c) is at `Data()[r * GetRowStride() + c * GetColStride()]`.
+     */
+    inline float* Data() { return m_externalData != nullptr ? m_externalData : m_data.data(); }
+    inline const float* Data() const { return m_externalData != nullptr ? m_externalData : m_data.data(); }
+    inline Gemm::Operand AsOperand() const { return {Data(), GetRowStride(), GetColStride()}; }
+    inline Gemm::Output AsOutput() { return {Data(), GetRowStride(), GetColStride()}; }
     FloatMatrix GetColumns(size_t begin, size_t end) const;
     FloatMatrix GetColumns(const std::vector<size_t>& indices) const;
 
+    inline FloatMatrixView View() const {
+      return FloatMatrixView(Data(), m_rows, m_cols, m_leadingDimension, m_transposed);
+    }
+    inline operator FloatMatrixView() const { return View(); }
+
+    /**
+     * @brief Returns the view of columns [begin, end] without copying them, compare with `GetColumns`.
+     */
+    inline FloatMatrixView ViewColumns(size_t begin, size_t end) const { return View().GetColumns(begin, end); }
+
+    /**
+     * @brief Resizes the matrix to (rows x cols) in the row-major layout. Nothing happens when the shape already
+     * matches (the data and the layout are kept), otherwise the contents are unspecified. The storage never shrinks, so
+     * a matrix reused with the same shape does not allocate.
+     */
+    void EnsureShape(size_t rows, size_t cols);
+    void EnsureShape(size_t rows, size_t cols, bool transposed);
+
+    /**
+     * @brief Copies the values into the buffer (of at least `GetSize()` elements) in the row-major order and releases
+     * the own storage, the matrix then reads and writes the buffer. Used to place matrices into a larger contiguous
+     * buffer (e.g. all parameters of a network). The buffer has to outlive the matrix.
+     *
+     * @note The matrix can change the shape only as long as the number of elements stays the same.
+     */
+    void MoveToExternalStorage(float* data);
+    inline bool HasExternalStorage() const { return m_externalData != nullptr; }
+
+    // Output-parameter variants of the operations below. The operands are read through views (any FloatMatrix converts
+    // to one). The destination is resized with `EnsureShape`, so a destination reused across iterations is written
+    // without allocating. A non-zero beta accumulates into the current contents of the destination, which then has to
+    // have the shape of the result already.
+
+    /**
+     * @brief Copies columns [begin, end] of the matrix into the destination, keeping the layout of the source.
+     */
+    static void GatherColumnsInto(FloatMatrix& destination, FloatMatrixView matrix, size_t begin, size_t end);
+    static void GatherColumnsInto(
+        FloatMatrix& destination, FloatMatrixView matrix, const std::vector<size_t>& indices);
+    static void GatherColumnsInto(FloatMatrix& destination, FloatMatrixView matrix, std::span<const size_t> indices);
+
+    /**
+     * @brief destination = alpha * a + beta * b. The destination may be one of the operands.
+     */
+    static void AddInto(
+        FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha = 1.0f, float beta = 1.0f);
+
+    /**
+     * @brief destination = alpha * (a ∘ b) + beta * destination. The destination may be one of the operands.
+     */
+    static void HadamardInto(
+        FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha = 1.0f, float beta = 0.0f);
+
+    /**
+     * @brief destination = alpha * (sum of the columns of matrix) + beta * destination.
+     */
+    static void SumColumnsInto(
+        FloatMatrix& destination, FloatMatrixView matrix, float alpha = 1.0f, float beta = 0.0f);
+
+    /**
+     * @brief destination = alpha * a * b + beta * destination, see `operator*`.
+     *
+     * @throws FloatMatrixInvalidDimensionException if the dimensions do not match or the destination is an operand
+     */
+    static void MultiplyInto(
+        FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha = 1.0f, float beta = 0.0f);
+
+    /**
+     * @brief destination = alpha * transpose(a) * b + beta * destination, see `MultiplyTransA`.
+     */
+    static void MultiplyTransAInto(
+        FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha = 1.0f, float beta = 0.0f);
+
+    /**
+     * @brief destination = alpha * a * transpose(b) + beta * destination, see `MultiplyTransB`.
+     */
+    static void MultiplyTransBInto(
+        FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, float alpha = 1.0f, float beta = 0.0f);
+
     FloatMatrix operator+(const FloatMatrix& other) const;
     FloatMatrix& operator+=(const FloatMatrix& other);
     FloatMatrix operator-(const FloatMatrix& other) const;
@@ -53,8 +206,9 @@ namespace nnn {
     /**
      * @brief Performs standart matrix-matrix multiplication.
      *
-     * The calculation is parallelized using OpenMP if the _OPENMP macro is defined,
-     * otherwise, it defaults to a serial implementation (see `MultiplySerial` method).
+     * The calculation is done by the cache-blocked packed GEMM engine (see `Gemm::Multiply`) and is parallelized over
+     * output tiles using OpenMP if the _OPENMP macro is defined, otherwise, it defaults to a serial implementation (see
+     * `MultiplySerial` method). Both operands may be transposed, the layout is resolved while packing.
      *
      * @param other the right-hand side FloatMatrix in the multiplication (B in A * B)
      * @return new FloatMatrix containing the result of the matrix product
@@ -62,25 +216,118 @@ namespace nnn {
      * current matrix does not match the number of rows in the 'other' matrix
      */
     FloatMatrix operator*(const FloatMatrix& other) const;
+
+    /**
+     * @brief Same as `operator*`, but always single-threaded. The result is bitwise identical to the parallel one.
+     */
     FloatMatrix MultiplySerial(const FloatMatrix& other) const;
+
+    /**
+     * @brief Computes transpose(this) * other without touching the transposition flag of either matrix. The packing
+     * of the GEMM engine reads both operands along their contiguous dimension, so no strided dot product is run.
+     *
+     * @throws FloatMatrixInvalidDimensionException if the row counts of both matrices do not match
+     */
+    FloatMatrix MultiplyTransA(const FloatMatrix& other) const;
+
+    /**
+     * @brief Computes this * transpose(other) without touching the transposition flag of either matrix.
+     *
+     * @throws FloatMatrixInvalidDimensionException if the column counts of both matrices do not match
+     */
+    FloatMatrix MultiplyTransB(const FloatMatrix& other) const;
     FloatMatrix operator*(float scalar) const;
     FloatMatrix& operator*=(float scalar);
     bool operator==(const FloatMatrix& other) const;
 
-    FloatMatrix Map(const std::function<float(float)>& func) const;
-    void MapInPlace(const std::function<float(float)>& func);
+    /**
+     * @brief Applies the function to every element. Any callable is accepted and inlined, so simple functions are
+     * vectorized by the compiler. Large matrices are processed by multiple OpenMP threads (the result does not depend
+     * on the number of threads), so the function has to be thread-safe.
+     */
+    template <typename Func>
+    FloatMatrix Map(Func&& func) const {  //
+
+      FloatMatrix result(m_rows, m_cols);
+      result.m_transposed = m_transposed;
+      result.m_leadingDimension = GetLineLength();
+      ApplyElementWise(Data(), m_leadingDimension, result.Data(), result.m_leadingDimension, func);
+      return result;
+    }
+
+    template <typename Func>
+    void MapInPlace(Func&& func) {  //
+
+      ApplyElementWise(Data(), m_leadingDimension, Data(), m_leadingDimension, func);
+    }
+
+    /**
+     * @brief Applies the function in-place to the elements of the given block only.
+     */
+    template <typename Func>
+    void MapInPlace(const Gemm::Tile& block, Func&& func) {  //
+
+      const size_t rowStride = GetRowStride();
+      const size_t colStride = GetColStride();
+      for (size_t r = block.rowBegin; r < block.rowEnd; ++r) {
+        float* row = Data() + r * rowStride;
+        if (colStride == 1) {
+          for (size_t c = block.colBegin; c < block.colEnd; ++c) {
+            row[c] = func(row[c]);
+          }
+        } else {
+          for (size_t c = block.colBegin; c < block.colEnd; ++c) {
+            row[c * colStride] = func(row[c * colStride]);
+          }
+        }
+      }
+    }
+
     void AddToAllCols(const FloatMatrix& vector);
     FloatMatrix Hadamard(const FloatMatrix& other) const;
 
-    template <typename T>
-    T Aggregate(const std::function<T(float)>& func) const {  //
+    /**
+     * @brief Sums the function values over all elements. For arithmetic types, the sum is split into chunks of fixed
+     * size summed by multiple threads and each chunk into independent lanes, so that the loop vectorizes (the order of
+     * summation is fixed and does not depend on the number of threads, but differs from a plain left-to-right sum).
+     */
+    template <typename T, typename Func>
+    T Aggregate(Func&& func) const {  //
+
+      const bool isContiguous = IsContiguous();
+      const size_t lineCount = isContiguous ? 1 : GetLineCount();
+      const size_t lineLength = isContiguous ? GetStorageSize() : GetLineLength();
 
-      T result{};
-      for (size_t i = 0; i < m_data.size(); ++i) {
-        result += func(m_data[i]);
-      }
+      if constexpr (std::is_arithmetic_v<T>) {
+        const size_t chunksPerLine = (lineLength + Parallel::CHUNK_SIZE - 1) / Parallel::CHUNK_SIZE;
+        // a sum per chunk (not per thread, to keep the order of summation fixed), the buffer of the calling thread is
+        // reused so that e.g. the loss of every batch is summed without allocating
+        thread_local std::vector<T> partials;
+        partials.resize(lineCount * chunksPerLine);
+        T* const partialSums = partials.data();  // the workers must not see their own thread_local buffers
 
-      return result;
+        Parallel::For(partials.size(), GetSize(), [&](size_t index) {
+          const size_t line = index / chunksPerLine;
+          const size_t begin = (index % chunksPerLine) * Parallel::CHUNK_SIZE;
+          const size_t size = std::min(Parallel::CHUNK_SIZE, lineLength - begin);
+          partialSums[index] = SumLanes<T>(Data() + line * m_leadingDimension + begin, size, func);
+        });
+
+        T result{};
+        for (const T& partial : partials) {
+          result += partial;
+        }
+        return result;
+      } else {
+        T result{};
+        for (size_t line = 0; line < lineCount; ++line) {
+          const float* data = Data() + line * m_leadingDimension;
+          for (size_t i = 0; i < lineLength; ++i) {
+            result += func(data[i]);
+          }
+        }
+        return result;
+      }
     }
 
     static FloatMatrix SumColumns(const FloatMatrix& matrix);
@@ -91,9 +338,77 @@ namespace nnn {
    private:
     FloatMatrix(size_t rows, size_t cols, float initialValue);
 
+    template <typename Expression>
+    void Assign(const Expression& expression);
+
+    inline size_t GetStorageSize() const { return m_externalData != nullptr ? GetSize() : m_data.size(); }
+    void ResizeStorage(size_t size);
+    void CopyValuesIntoExternalStorage(const FloatMatrix& other);
+
+    /**
+     * @brief Applies the function to every element of the source and writes it to the destination, both have the
+     * shape of this matrix, the given leading dimensions and the same transposition. Runs in parallel for large
+     * matrices, see `Parallel::GetElementThreshold`.
+     */
+    template <typename Func>
+    void ApplyElementWise(const float* source, size_t sourceLd, float* destination, size_t destinationLd,
+        Func& func) const {  //
+
+      const size_t lineLength = GetLineLength();
+      if (sourceLd == lineLength && destinationLd == lineLength) {
+        Parallel::ForChunks(GetSize(), [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            destination[i] = func(source[i]);
+          }
+        });
+      } else {
+        Parallel::For(GetLineCount(), GetSize(), [&](size_t line) {
+          const float* sourceLine = source + line * sourceLd;
+          float* destinationLine = destination + line * destinationLd;
+          for (size_t i = 0; i < lineLength; ++i) {
+            destinationLine[i] = func(sourceLine[i]);
+          }
+        });
+      }
+    }
+
+    template <typename T, typename Func>
+    static T SumLanes(const float* data, size_t size, Func& func) {  //
+
+      constexpr size_t LANES = 8;
+      T lanes[LANES] = {};
+      size_t i = 0;
+      for (; i + LANES <= size; i += LANES) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+          lanes[lane] += func(data[i + lane]);
+        }
+      }
+      for (; i < size; ++i) {
+        lanes[i % LANES] += func(data[i]);
+      }
+
+      T result{};
+      for (size_t lane = 0; lane < LANES; ++lane) {
+        result += lanes[lane];
+      }
+      return result;
+    }
+
+    static void CheckSameDimensions(FloatMatrixView a, FloatMatrixView b, const char* operation);
+    static bool HaveSameContiguousLayout(FloatMatrixView a, FloatMatrixView b);
+    static bool Overlaps(const FloatMatrix& destination, FloatMatrixView source);
+    static void CheckNotAliased(const FloatMatrix& destination, FloatMatrixView source);
+    static void CheckElementWiseAliasing(const FloatMatrix& destination, FloatMatrixView source);
+    static void PrepareProductDestination(
+        FloatMatrix& destination, FloatMatrixView a, FloatMatrixView b, size_t rows, size_t cols, float beta);
+
     inline size_t ComputeIndex(size_t row, size_t col) const {
-      return (m_transposed) ? (row + m_rows * col) : (row * m_cols + col);
+      return (m_transposed) ? (row + m_leadingDimension * col) : (row * m_leadingDimension + col);
     }
+
+    // The storage consists of GetLineCount() lines of GetLineLength() elements, m_leadingDimension elements apart.
+    inline size_t GetLineCount() const { return m_transposed ? m_cols : m_rows; }
+    inline size_t GetLineLength() const { return m_transposed ? m_rows : m_cols; }
   };
 
 }  // namespace nnn
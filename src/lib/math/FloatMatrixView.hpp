@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Gemm.hpp"
+
+namespace nnn {
+
+  /**
+   * @brief Non-owning, read-only view of (a part of) a FloatMatrix. It uses the same addressing as FloatMatrix: the
+   * storage consists of lines (rows, or columns when transposed) `leadingDimension` elements apart.
+   *
+   * Views are cheap to copy and are accepted by all read-only kernels, every FloatMatrix converts to a view of itself.
+   *
+   * @warning The view does not extend the lifetime of the matrix and is invalidated when the matrix is resized.
+   */
+  class FloatMatrixView {
+   private:
+    const float* m_data;
+    size_t m_rows;
+    size_t m_cols;
+    size_t m_leadingDimension;
+    bool m_transposed;
+
+   public:
+    FloatMatrixView(const float* data, size_t rows, size_t cols, size_t leadingDimension, bool transposed)
+        : m_data(data), m_rows(rows), m_cols(cols), m_leadingDimension(leadingDimension), m_transposed(transposed) {}
+
+    inline size_t GetSize() const { return m_rows * m_cols; }
+    inline size_t GetRowCount() const { return m_rows; }
+    inline size_t GetColCount() const { return m_cols; }
+    inline bool IsTransposed() const { return m_transposed; }
+    inline size_t GetLeadingDimension() const { return m_leadingDimension; }
+    inline bool IsContiguous() const { return m_leadingDimension == (m_transposed ? m_rows : m_cols); }
+    inline size_t GetRowStride() const { return m_transposed ? 1 : m_leadingDimension; }
+    inline size_t GetColStride() const { return m_transposed ? m_leadingDimension : 1; }
+
+    inline const float* Data() const { return m_data; }
+    inline Gemm::Operand AsOperand() const { return {m_data, GetRowStride(), GetColStride()}; }
+
+    inline const float& operator()(size_t row, size_t col) const {
+      return m_data[(m_transposed) ? (row + m_leadingDimension * col) : (row * m_leadingDimension + col)];
+    }
+
+    /**
+     * @brief Returns the view of columns [begin, end] (no data is copied).
+     */
+    inline FloatMatrixView GetColumns(size_t begin, size_t end) const {
+      return FloatMatrixView(
+          m_data + begin * GetColStride(), m_rows, end - begin + 1, m_leadingDimension, m_transposed);
+    }
+  };
+}  // namespace nnn
@@ -0,0 +1,271 @@
+#include "Gemm.hpp"
+#include "GemmKernels.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <new>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+  // Cache blocking: a KC x NR micro-panel of B stays in L1, an MC x KC block of A stays in L2 and a KC x NC panel of B
+  // stays in L3.
+  constexpr size_t KC = 256;
+  constexpr size_t MC = 128;
+  constexpr size_t NC = 2048;
+
+  // Products smaller than this (in multiply-adds) are not worth waking up the thread pool.
+  constexpr size_t PARALLEL_WORK_THRESHOLD = 64 * 64 * 64;
+
+  constexpr std::align_val_t BUFFER_ALIGNMENT{64};
+
+  /**
+   * @brief Grow-only, cache-line aligned scratch memory for packed panels. Each thread owns its own instance, so the
+   * steady state does not allocate.
+   */
+  class PackingBuffer {
+   public:
+    float* Reserve(size_t count) {
+      if (count > m_capacity) {
+        m_data.reset(static_cast<float*>(::operator new(count * sizeof(float), BUFFER_ALIGNMENT)));
+        m_capacity = count;
+      }
+      return m_data.get();
+    }
+
+   private:
+    struct Deleter {
+      void operator()(float* ptr) const { ::operator delete(ptr, BUFFER_ALIGNMENT); }
+    };
+
+    std::unique_ptr<float, Deleter> m_data;
+    size_t m_capacity = 0;
+  };
+
+  inline size_t RoundUp(size_t value, size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+  inline size_t CeilDiv(size_t value, size_t divisor) { return (value + divisor - 1) / divisor; }
+
+  inline int MaxThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  /**
+   * @brief Packs rows [row, row + rows) and columns [col, col + kc) of A into a micro-panel of mr interleaved rows,
+   * zero-padding missing rows. The loop order follows the contiguous dimension of the source.
+   */
+  void PackPanelA(nnn::Gemm::Operand a, size_t row, size_t rows, size_t col, size_t kc, size_t mr, float* dst) {  //
+
+    if (rows < mr) {
+      std::fill(dst, dst + kc * mr, 0.0f);
+    }
+
+    if (a.colStride == 1) {
+      for (size_t i = 0; i < rows; ++i) {
+        const float* src = a.data + (row + i) * a.rowStride + col;
+        for (size_t p = 0; p < kc; ++p) {
+          dst[p * mr + i] = src[p];
+        }
+      }
+    } else {
+      for (size_t p = 0; p < kc; ++p) {
+        const float* src = a.data + row * a.rowStride + (col + p) * a.colStride;
+        for (size_t i = 0; i < rows; ++i) {
+          dst[p * mr + i] = src[i * a.rowStride];
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Packs rows [row, row + kc) and columns [col, col + cols) of B into a micro-panel of nr interleaved columns,
+   * zero-padding missing columns. The loop order follows the contiguous dimension of the source.
+   */
+  void PackPanelB(nnn::Gemm::Operand b, size_t row, size_t kc, size_t col, size_t cols, size_t nr, float* dst) {  //
+
+    if (cols < nr) {
+      std::fill(dst, dst + kc * nr, 0.0f);
+    }
+
+    if (b.rowStride == 1) {
+      for (size_t j = 0; j < cols; ++j) {
+        const float* src = b.data + row + (col + j) * b.colStride;
+        for (size_t p = 0; p < kc; ++p) {
+          dst[p * nr + j] = src[p];
+        }
+      }
+    } else {
+      for (size_t p = 0; p < kc; ++p) {
+        const float* src = b.data + (row + p) * b.rowStride + col * b.colStride;
+        for (size_t j = 0; j < cols; ++j) {
+          dst[p * nr + j] = src[j * b.colStride];
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Merges a partial (edge) or non-contiguous tile computed into a scratch buffer into C.
+   */
+  void StoreTile(const float* tile, size_t ldt, size_t rows, size_t cols, nnn::Gemm::Output c, float beta) {
+    for (size_t i = 0; i < rows; ++i) {
+      for (size_t j = 0; j < cols; ++j) {
+        float& dst = c.data[i * c.rowStride + j * c.colStride];
+        dst = (beta == 0.0f) ? tile[i * ldt + j] : tile[i * ldt + j] + beta * dst;
+      }
+    }
+  }
+
+  void ScaleOutput(size_t m, size_t n, nnn::Gemm::Output c, float beta) {
+    for (size_t i = 0; i < m; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        float& dst = c.data[i * c.rowStride + j * c.colStride];
+        dst = (beta == 0.0f) ? 0.0f : beta * dst;
+      }
+    }
+  }
+
+  /**
+   * @brief Chooses the output tile size so that there are enough tiles to keep all threads busy, while keeping tiles
+   * as large as the cache blocking allows.
+   */
+  void ChooseTileSize(size_t m,
+      size_t n,
+      const nnn::Gemm::Kernel& kernel,
+      int threads,
+      bool isColumnWise,
+      size_t& tileRows,
+      size_t& tileCols) {  //
+
+    const size_t minTileRows = isColumnWise ? RoundUp(m, kernel.mr) : kernel.mr;
+    tileRows = isColumnWise ? minTileRows : std::min(RoundUp(MC, kernel.mr), RoundUp(m, kernel.mr));
+    tileCols = std::min(RoundUp(NC, kernel.nr), RoundUp(n, kernel.nr));
+
+    const size_t wantedTiles = static_cast<size_t>(threads) * 2;
+    while (CeilDiv(m, tileRows) * CeilDiv(n, tileCols) < wantedTiles &&
+           (tileRows > minTileRows || tileCols > kernel.nr)) {
+      if ((tileCols >= tileRows || tileRows <= minTileRows) && tileCols > kernel.nr) {
+        tileCols = RoundUp(tileCols / 2, kernel.nr);
+      } else {
+        tileRows = RoundUp(tileRows / 2, kernel.mr);
+      }
+    }
+  }
+}  // namespace
+
+namespace nnn::Gemm {
+
+  void Multiply(size_t m, size_t n, size_t k, Operand a, Operand b, Output c, const Parameters& params) {  //
+
+    if (m == 0 || n == 0) {
+      return;
+    }
+
+    if (k == 0 || params.alpha == 0.0f) {
+      ScaleOutput(m, n, c, params.beta);
+      if (params.epilogue) {
+        params.epilogue({0, m, 0, n});
+      }
+      return;
+    }
+
+    const bool isParallel = params.isParallel && m * n * k >= PARALLEL_WORK_THRESHOLD && MaxThreads() > 1;
+    const int threads = isParallel ? MaxThreads() : 1;
+
+    const Kernel kernel = GetActiveKernel();
+    const size_t mr = kernel.mr;
+    const size_t nr = kernel.nr;
+    const size_t ncMax = RoundUp(NC, nr);
+
+    static thread_local PackingBuffer bufferA;
+    static thread_local PackingBuffer bufferB;
+
+    const size_t panelsA = CeilDiv(m, mr);
+    float* packedA = bufferA.Reserve(panelsA * mr * std::min(k, KC));
+    float* packedB = bufferB.Reserve(CeilDiv(std::min(n, ncMax), nr) * nr * std::min(k, KC));
+
+    std::exception_ptr epilogueError = nullptr;
+
+    for (size_t pc = 0; pc < k; pc += KC) {  //
+
+      const size_t kc = std::min(KC, k - pc);
+      const float beta = (pc == 0) ? params.beta : 1.0f;
+      const bool isLastPanel = pc + kc == k;
+
+#pragma omp parallel for schedule(static) if (isParallel)
+      for (int ip = 0; ip < static_cast<int>(panelsA); ++ip) {
+        const size_t row = ip * mr;
+        PackPanelA(a, row, std::min(mr, m - row), pc, kc, mr, packedA + ip * kc * mr);
+      }
+
+      for (size_t jc = 0; jc < n; jc += ncMax) {  //
+
+        const size_t nc = std::min(ncMax, n - jc);
+        const size_t panelsB = CeilDiv(nc, nr);
+
+#pragma omp parallel for schedule(static) if (isParallel)
+        for (int jp = 0; jp < static_cast<int>(panelsB); ++jp) {
+          const size_t col = jp * nr;
+          PackPanelB(b, pc, kc, jc + col, std::min(nr, nc - col), nr, packedB + jp * kc * nr);
+        }
+
+        size_t tileRows = 0;
+        size_t tileCols = 0;
+        ChooseTileSize(m, nc, kernel, threads, params.isEpilogueColumnWise, tileRows, tileCols);
+        const size_t rowTiles = CeilDiv(m, tileRows);
+        const size_t colTiles = CeilDiv(nc, tileCols);
+
+        // 2-D distribution of output tiles (flattened, so that it also works with OpenMP 2.0).
+#pragma omp parallel for schedule(static) if (isParallel)
+        for (int tile = 0; tile < static_cast<int>(rowTiles * colTiles); ++tile) {  //
+
+          const size_t rowBegin = (tile / colTiles) * tileRows;
+          const size_t rowEnd = std::min(m, rowBegin + tileRows);
+          const size_t colBegin = (tile % colTiles) * tileCols;
+          const size_t colEnd = std::min(nc, colBegin + tileCols);
+
+          alignas(64) float scratch[MAX_KERNEL_TILE];
+
+          for (size_t jr = colBegin; jr < colEnd; jr += nr) {
+            const float* panelB = packedB + (jr / nr) * kc * nr;
+            const size_t cols = std::min(nr, nc - jr);
+
+            for (size_t ir = rowBegin; ir < rowEnd; ir += mr) {
+              const float* panelA = packedA + (ir / mr) * kc * mr;
+              const size_t rows = std::min(mr, m - ir);
+              float* target = c.data + ir * c.rowStride + (jc + jr) * c.colStride;
+
+              if (rows == mr && cols == nr && c.colStride == 1) {
+                kernel.compute(kc, panelA, panelB, target, c.rowStride, params.alpha, beta);
+              } else {
+                kernel.compute(kc, panelA, panelB, scratch, nr, params.alpha, 0.0f);
+                StoreTile(scratch, nr, rows, cols, {target, c.rowStride, c.colStride}, beta);
+              }
+            }
+
+            if (isLastPanel && params.epilogue) {
+              try {
+                params.epilogue({rowBegin, rowEnd, jc + jr, jc + jr + cols});
+              } catch (...) {
+#pragma omp critical(nnnGemmEpilogueError)
+                epilogueError = std::current_exception();
+              }
+            }
+          }
+        }
+      }
+    }
+
+    if (epilogueError) {
+      std::rethrow_exception(epilogueError);
+    }
+  }
+}  // namespace nnn::Gemm
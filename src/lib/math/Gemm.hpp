@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace nnn::Gemm {
+
+  /**
+   * @brief Read-only strided operand of the multiplication, element (r, c) is stored at `data[r * rowStride + c *
+   * colStride]`. This covers both the row-major and the transposed (column-major) layout of FloatMatrix.
+   */
+  struct Operand {
+    const float* data;
+    size_t rowStride;
+    size_t colStride;
+  };
+
+  /**
+   * @brief Reinterprets the operand as its transpose (no data is moved).
+   */
+  inline Operand Transposed(Operand operand) { return {operand.data, operand.colStride, operand.rowStride}; }
+
+  /**
+   * @brief Writable strided destination of the multiplication, see `Operand` for the addressing scheme.
+   */
+  struct Output {
+    float* data;
+    size_t rowStride;
+    size_t colStride;
+  };
+
+  /**
+   * @brief Block [rowBegin, rowEnd) x [colBegin, colEnd) of the output matrix.
+   */
+  struct Tile {
+    size_t rowBegin;
+    size_t rowEnd;
+    size_t colBegin;
+    size_t colEnd;
+  };
+
+  struct Parameters {
+    float alpha = 1.0f;
+    float beta = 0.0f;
+    bool isParallel = true;
+
+    /**
+     * @brief Optional callback invoked exactly once for every finished block of C (after the last panel of the inner
+     * dimension was accumulated), while the block is still hot in cache. Blocks of different threads never overlap.
+     */
+    std::function<void(const Tile&)> epilogue = {};
+
+    /**
+     * @brief Forces every block passed to the epilogue to span all rows of C (e.g. for softmax over columns).
+     */
+    bool isEpilogueColumnWise = false;
+  };
+
+  /**
+   * @brief Computes C = alpha * A * B + beta * C, where A is (m x k), B is (k x n) and C is (m x n).
+   *
+   * Operand panels are packed into contiguous, zero-padded buffers (the layout of A and B is resolved during packing,
+   * not per element), the product is tiled for L1/L2/L3 caches and output tiles are distributed among OpenMP threads in
+   * two dimensions. The order of summation for a single element does not depend on the number of threads, so the
+   * parallel and serial results are identical.
+   *
+   * @note When beta is zero, C is never read (it may contain garbage).
+   * @note An exception thrown by the epilogue is rethrown once all threads finish.
+   */
+  void Multiply(
+      size_t m, size_t n, size_t k, Operand a, Operand b, Output c, const Parameters& params = Parameters());
+}  // namespace nnn::Gemm
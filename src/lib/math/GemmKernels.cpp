@@ -0,0 +1,215 @@
+#include "GemmKernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define NNN_GEMM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows intrinsics of any instruction set without special flags, GCC and Clang need per-function targets, so that
+// the rest of the library can still be compiled for the baseline ISA.
+#if defined(NNN_GEMM_X86) && !defined(_MSC_VER)
+#define NNN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NNN_TARGET(isa)
+#endif
+
+namespace {
+
+  // ---------------------------------------------------------------------------------------------------------------
+  // Scalar
+
+  constexpr size_t SCALAR_MR = 4;
+  constexpr size_t SCALAR_NR = 8;
+
+  void ScalarKernel(size_t k, const float* a, const float* b, float* c, size_t ldc, float alpha, float beta) {  //
+
+    float acc[SCALAR_MR][SCALAR_NR] = {};
+    for (size_t p = 0; p < k; ++p) {
+      const float* bp = b + p * SCALAR_NR;
+      for (size_t i = 0; i < SCALAR_MR; ++i) {
+        const float ai = a[p * SCALAR_MR + i];
+        for (size_t j = 0; j < SCALAR_NR; ++j) {
+          acc[i][j] += ai * bp[j];
+        }
+      }
+    }
+
+    for (size_t i = 0; i < SCALAR_MR; ++i) {
+      float* ci = c + i * ldc;
+      if (beta == 0.0f) {
+        for (size_t j = 0; j < SCALAR_NR; ++j) {
+          ci[j] = alpha * acc[i][j];
+        }
+      } else {
+        for (size_t j = 0; j < SCALAR_NR; ++j) {
+          ci[j] = alpha * acc[i][j] + beta * ci[j];
+        }
+      }
+    }
+  }
+
+#ifdef NNN_GEMM_X86
+
+  // ---------------------------------------------------------------------------------------------------------------
+  // AVX2 + FMA: 6 x 16 block, 12 accumulators + 2 B vectors + 1 broadcast out of 16 ymm registers.
+
+  constexpr size_t AVX2_MR = 6;
+  constexpr size_t AVX2_NR = 16;
+
+  NNN_TARGET("avx2,fma")
+  void Avx2Kernel(size_t k, const float* a, const float* b, float* c, size_t ldc, float alpha, float beta) {  //
+
+    __m256 acc[AVX2_MR][2];
+    for (size_t i = 0; i < AVX2_MR; ++i) {
+      acc[i][0] = _mm256_setzero_ps();
+      acc[i][1] = _mm256_setzero_ps();
+    }
+
+    for (size_t p = 0; p < k; ++p) {
+      const __m256 b0 = _mm256_loadu_ps(b + p * AVX2_NR);
+      const __m256 b1 = _mm256_loadu_ps(b + p * AVX2_NR + 8);
+      for (size_t i = 0; i < AVX2_MR; ++i) {
+        const __m256 ai = _mm256_broadcast_ss(a + p * AVX2_MR + i);
+        acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+        acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+      }
+    }
+
+    const __m256 alphaVector = _mm256_set1_ps(alpha);
+    const __m256 betaVector = _mm256_set1_ps(beta);
+    for (size_t i = 0; i < AVX2_MR; ++i) {
+      float* ci = c + i * ldc;
+      if (beta == 0.0f) {
+        _mm256_storeu_ps(ci, _mm256_mul_ps(alphaVector, acc[i][0]));
+        _mm256_storeu_ps(ci + 8, _mm256_mul_ps(alphaVector, acc[i][1]));
+      } else {
+        _mm256_storeu_ps(ci, _mm256_fmadd_ps(alphaVector, acc[i][0], _mm256_mul_ps(betaVector, _mm256_loadu_ps(ci))));
+        _mm256_storeu_ps(
+            ci + 8, _mm256_fmadd_ps(alphaVector, acc[i][1], _mm256_mul_ps(betaVector, _mm256_loadu_ps(ci + 8))));
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------------------------------------------------
+  // AVX-512F: 12 x 32 block, 24 accumulators + 2 B vectors + 1 broadcast out of 32 zmm registers.
+
+  constexpr size_t AVX512_MR = 12;
+  constexpr size_t AVX512_NR = 32;
+
+  NNN_TARGET("avx512f")
+  void Avx512Kernel(size_t k, const float* a, const float* b, float* c, size_t ldc, float alpha, float beta) {  //
+
+    __m512 acc[AVX512_MR][2];
+    for (size_t i = 0; i < AVX512_MR; ++i) {
+      acc[i][0] = _mm512_setzero_ps();
+      acc[i][1] = _mm512_setzero_ps();
+    }
+
+    for (size_t p = 0; p < k; ++p) {
+      const __m512 b0 = _mm512_loadu_ps(b + p * AVX512_NR);
+      const __m512 b1 = _mm512_loadu_ps(b + p * AVX512_NR + 16);
+      for (size_t i = 0; i < AVX512_MR; ++i) {
+        const __m512 ai = _mm512_set1_ps(a[p * AVX512_MR + i]);
+        acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+        acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+      }
+    }
+
+    const __m512 alphaVector = _mm512_set1_ps(alpha);
+    const __m512 betaVector = _mm512_set1_ps(beta);
+    for (size_t i = 0; i < AVX512_MR; ++i) {
+      float* ci = c + i * ldc;
+      if (beta == 0.0f) {
+        _mm512_storeu_ps(ci, _mm512_mul_ps(alphaVector, acc[i][0]));
+        _mm512_storeu_ps(ci + 16, _mm512_mul_ps(alphaVector, acc[i][1]));
+      } else {
+        _mm512_storeu_ps(ci, _mm512_fmadd_ps(alphaVector, acc[i][0], _mm512_mul_ps(betaVector, _mm512_loadu_ps(ci))));
+        _mm512_storeu_ps(
+            ci + 16, _mm512_fmadd_ps(alphaVector, acc[i][1], _mm512_mul_ps(betaVector, _mm512_loadu_ps(ci + 16))));
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------------------------------------------------
+  // CPU feature detection
+
+  struct CpuFeatures {
+    bool avx2Fma = false;
+    bool avx512f = false;
+  };
+
+  CpuFeatures DetectCpuFeatures() {  //
+
+    CpuFeatures features;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || maxLeaf < 7) {
+      return features;
+    }
+
+    // The OS has to save the ymm (and zmm) registers on context switch.
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool osAvx = (xcr0 & 0x6) == 0x6;
+    const bool osAvx512 = (xcr0 & 0xe6) == 0xe6;
+
+    __cpuidex(info, 7, 0);
+    features.avx2Fma = osAvx && fma && (info[1] & (1 << 5)) != 0;
+    features.avx512f = osAvx512 && (info[1] & (1 << 16)) != 0;
+#else
+    __builtin_cpu_init();
+    features.avx2Fma = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    features.avx512f = __builtin_cpu_supports("avx512f");
+#endif
+    return features;
+  }
+
+#endif
+
+  std::vector<nnn::Gemm::Kernel> DetectAvailableKernels() {  //
+
+    std::vector<nnn::Gemm::Kernel> kernels = {nnn::Gemm::GetScalarKernel()};
+
+#ifdef NNN_GEMM_X86
+    const CpuFeatures features = DetectCpuFeatures();
+    if (features.avx2Fma) {
+      kernels.push_back({"avx2", AVX2_MR, AVX2_NR, Avx2Kernel});
+    }
+    if (features.avx512f) {
+      kernels.push_back({"avx512", AVX512_MR, AVX512_NR, Avx512Kernel});
+    }
+#endif
+
+    return kernels;
+  }
+
+  nnn::Gemm::Kernel& ActiveKernel() {
+    static nnn::Gemm::Kernel kernel = nnn::Gemm::GetAvailableKernels().back();
+    return kernel;
+  }
+}  // namespace
+
+namespace nnn::Gemm {
+
+  const Kernel& GetScalarKernel() {
+    static const Kernel kernel = {"scalar", SCALAR_MR, SCALAR_NR, ScalarKernel};
+    return kernel;
+  }
+
+  const std::vector<Kernel>& GetAvailableKernels() {
+    static const std::vector<Kernel> kernels = DetectAvailableKernels();
+    return kernels;
+  }
+
+  const Kernel& GetActiveKernel() { return ActiveKernel(); }
+
+  void SetActiveKernel(const Kernel& kernel) { ActiveKernel() = kernel; }
+}  // namespace nnn::Gemm
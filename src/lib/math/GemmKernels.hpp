@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace nnn::Gemm {
+
+  /**
+   * @brief Register-blocked micro-kernel, computes the (mr x nr) block C = alpha * A * B + beta * C from a packed
+   * micro-panel of A (k x mr, rows interleaved) and a packed micro-panel of B (k x nr, columns interleaved). C is
+   * addressed with the row stride `ldc` and unit column stride. When beta is zero, C is not read.
+   */
+  using MicroKernelFunction = void (*)(
+      size_t k, const float* a, const float* b, float* c, size_t ldc, float alpha, float beta);
+
+  struct Kernel {
+    const char* name;
+    size_t mr;
+    size_t nr;
+    MicroKernelFunction compute;
+  };
+
+  /**
+   * @brief Upper bound of mr * nr over all kernels, used for sizing the scratch tile on stack.
+   */
+  constexpr size_t MAX_KERNEL_TILE = 16 * 32;
+
+  /**
+   * @brief Portable fallback kernel, relies on compiler auto-vectorization only.
+   */
+  const Kernel& GetScalarKernel();
+
+  /**
+   * @brief Lists all kernels the current CPU is able to run, from the narrowest (scalar) to the widest.
+   */
+  const std::vector<Kernel>& GetAvailableKernels();
+
+  /**
+   * @brief Returns the kernel used by `Gemm::Multiply`. The widest kernel supported by the CPU is selected on first
+   * use based on cpuid.
+   */
+  const Kernel& GetActiveKernel();
+
+  /**
+   * @brief Overrides the kernel used by `Gemm::Multiply` (for testing and benchmarking). Not thread-safe with respect
+   * to running multiplications.
+   */
+  void SetActiveKernel(const Kernel& kernel);
+}  // namespace nnn::Gemm
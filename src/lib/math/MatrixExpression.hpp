@@ -0,0 +1,200 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+#include "FloatMatrix.hpp"
+#include "FloatMatrixInvalidDimensionException.hpp"
+#include "Parallel.hpp"
+
+// Expression templates for element-wise FloatMatrix arithmetic. An expression like
+//
+//   velocity = Lazy(velocity) * momentum + gradient;
+//
+// builds a tree of lightweight nodes instead of temporaries and is evaluated in a single loop on assignment to a
+// FloatMatrix. Both matrices and views can be operands. Nodes hold views of the matrices they read, so an expression
+// has to be evaluated before any of its operands go out of scope (i.e. do not keep it in an `auto` variable across
+// statements).
+
+namespace nnn {
+
+  /**
+   * @brief Base of all expression nodes (CRTP). Every node provides `GetRowCount()`, `GetColCount()`, the logical
+   * element accessor `operator()(row, col)`, the storage accessor `At(index)` and `HasLayout(transposed)`, which tells
+   * whether all matrices in the expression share the given contiguous layout (only then `At` may be used).
+   */
+  template <typename Derived>
+  class MatrixExpression {
+   public:
+    inline const Derived& Self() const { return static_cast<const Derived&>(*this); }
+  };
+
+  template <typename T>
+  concept IsMatrixExpression = std::is_base_of_v<MatrixExpression<T>, T>;
+
+  template <typename T>
+  concept IsMatrixOperand =
+      IsMatrixExpression<T> || std::same_as<T, FloatMatrix> || std::same_as<T, FloatMatrixView>;
+
+  class MatrixReference : public MatrixExpression<MatrixReference> {
+   private:
+    FloatMatrixView m_matrix;
+
+   public:
+    explicit MatrixReference(FloatMatrixView matrix) : m_matrix(matrix) {}
+
+    inline size_t GetRowCount() const { return m_matrix.GetRowCount(); }
+    inline size_t GetColCount() const { return m_matrix.GetColCount(); }
+    inline bool HasLayout(bool transposed) const {
+      return m_matrix.IsTransposed() == transposed && m_matrix.IsContiguous();
+    }
+    inline float operator()(size_t row, size_t col) const { return m_matrix(row, col); }
+    inline float At(size_t index) const { return m_matrix.Data()[index]; }
+  };
+
+  template <typename Expression>
+  class ScaledExpression : public MatrixExpression<ScaledExpression<Expression>> {
+   private:
+    Expression m_expression;
+    float m_scalar;
+
+   public:
+    ScaledExpression(const Expression& expression, float scalar) : m_expression(expression), m_scalar(scalar) {}
+
+    inline size_t GetRowCount() const { return m_expression.GetRowCount(); }
+    inline size_t GetColCount() const { return m_expression.GetColCount(); }
+    inline bool HasLayout(bool transposed) const { return m_expression.HasLayout(transposed); }
+    inline float operator()(size_t row, size_t col) const { return m_expression(row, col) * m_scalar; }
+    inline float At(size_t index) const { return m_expression.At(index) * m_scalar; }
+  };
+
+  struct AddOperation {
+    static constexpr const char* NAME = "add matrices";
+    static inline float Apply(float left, float right) { return left + right; }
+  };
+
+  struct SubtractOperation {
+    static constexpr const char* NAME = "subtract matrices";
+    static inline float Apply(float left, float right) { return left - right; }
+  };
+
+  struct HadamardOperation {
+    static constexpr const char* NAME = "compute hadamard product for matrices";
+    static inline float Apply(float left, float right) { return left * right; }
+  };
+
+  template <typename Left, typename Right, typename Operation>
+  class BinaryExpression : public MatrixExpression<BinaryExpression<Left, Right, Operation>> {
+   private:
+    Left m_left;
+    Right m_right;
+
+   public:
+    /**
+     * @throws FloatMatrixInvalidDimensionException if the dimensions of the operands do not match
+     */
+    BinaryExpression(const Left& left, const Right& right) : m_left(left), m_right(right) {  //
+
+      if (left.GetRowCount() != right.GetRowCount()) {
+        throw FloatMatrixInvalidDimensionException(
+            ("Cannot " + std::string(Operation::NAME) + " when row count does not match.").c_str());
+      } else if (left.GetColCount() != right.GetColCount()) {
+        throw FloatMatrixInvalidDimensionException(
+            ("Cannot " + std::string(Operation::NAME) + " when column count does not match.").c_str());
+      }
+    }
+
+    inline size_t GetRowCount() const { return m_left.GetRowCount(); }
+    inline size_t GetColCount() const { return m_left.GetColCount(); }
+    inline bool HasLayout(bool transposed) const {
+      return m_left.HasLayout(transposed) && m_right.HasLayout(transposed);
+    }
+    inline float operator()(size_t row, size_t col) const {
+      return Operation::Apply(m_left(row, col), m_right(row, col));
+    }
+    inline float At(size_t index) const { return Operation::Apply(m_left.At(index), m_right.At(index)); }
+  };
+
+  /**
+   * @brief Entry point of lazy evaluation, wraps the matrix into an expression node.
+   */
+  inline MatrixReference Lazy(FloatMatrixView matrix) { return MatrixReference(matrix); }
+
+  template <typename T>
+  using ExpressionOf = std::conditional_t<IsMatrixExpression<T>, T, MatrixReference>;
+
+  inline MatrixReference ToExpression(FloatMatrixView matrix) { return MatrixReference(matrix); }
+
+  template <IsMatrixExpression Expression>
+  inline const Expression& ToExpression(const Expression& expression) {
+    return expression;
+  }
+
+  // At least one operand has to be an expression already, so that the eager FloatMatrix operators keep working.
+
+  template <IsMatrixOperand Left, IsMatrixOperand Right>
+    requires(IsMatrixExpression<Left> || IsMatrixExpression<Right>)
+  inline auto operator+(const Left& left, const Right& right) {
+    return BinaryExpression<ExpressionOf<Left>, ExpressionOf<Right>, AddOperation>(
+        ToExpression(left), ToExpression(right));
+  }
+
+  template <IsMatrixOperand Left, IsMatrixOperand Right>
+    requires(IsMatrixExpression<Left> || IsMatrixExpression<Right>)
+  inline auto operator-(const Left& left, const Right& right) {
+    return BinaryExpression<ExpressionOf<Left>, ExpressionOf<Right>, SubtractOperation>(
+        ToExpression(left), ToExpression(right));
+  }
+
+  template <IsMatrixOperand Left, IsMatrixOperand Right>
+    requires(IsMatrixExpression<Left> || IsMatrixExpression<Right>)
+  inline auto Hadamard(const Left& left, const Right& right) {
+    return BinaryExpression<ExpressionOf<Left>, ExpressionOf<Right>, HadamardOperation>(
+        ToExpression(left), ToExpression(right));
+  }
+
+  template <IsMatrixExpression Expression>
+  inline ScaledExpression<Expression> operator*(const Expression& expression, float scalar) {
+    return ScaledExpression<Expression>(expression, scalar);
+  }
+
+  template <IsMatrixExpression Expression>
+  inline ScaledExpression<Expression> operator*(float scalar, const Expression& expression) {
+    return ScaledExpression<Expression>(expression, scalar);
+  }
+
+  template <typename Expression>
+  FloatMatrix::FloatMatrix(const MatrixExpression<Expression>& expression) : m_rows(0), m_cols(0) {
+    Assign(expression.Self());
+  }
+
+  template <typename Expression>
+  FloatMatrix& FloatMatrix::operator=(const MatrixExpression<Expression>& expression) {
+    Assign(expression.Self());
+    return *this;
+  }
+
+  template <typename Expression>
+  void FloatMatrix::Assign(const Expression& expression) {  //
+
+    // Every element is written only after all its operands were read, so the destination may appear in the expression.
+    EnsureShape(expression.GetRowCount(), expression.GetColCount());
+
+    if (IsContiguous() && expression.HasLayout(m_transposed)) {
+      float* data = Data();
+      Parallel::ForChunks(GetStorageSize(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          data[i] = expression.At(i);
+        }
+      });
+    } else {
+      Parallel::For(m_rows, GetSize(), [&](size_t row) {
+        for (size_t col = 0; col < m_cols; ++col) {
+          (*this)(row, col) = expression(row, col);
+        }
+      });
+    }
+  }
+}  // namespace nnn
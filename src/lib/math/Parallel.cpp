@@ -0,0 +1,100 @@
+#include "Parallel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+  std::atomic<size_t> elementThreshold{64 * 1024};
+
+  /**
+   * @brief Best of several runs of the loop, in nanoseconds.
+   */
+  template <typename Loop>
+  long long MeasureBest(Loop&& loop) {  //
+
+    constexpr int REPETITIONS = 7;
+    long long best = INT64_MAX;
+    for (int i = 0; i < REPETITIONS; ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      loop();
+      const auto stop = std::chrono::steady_clock::now();
+      const long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+      best = elapsed < best ? elapsed : best;
+    }
+    return best;
+  }
+}  // namespace
+
+namespace nnn::Parallel {
+
+  size_t GetElementThreshold() { return elementThreshold.load(std::memory_order_relaxed); }
+
+  void SetElementThreshold(size_t threshold) { elementThreshold.store(threshold, std::memory_order_relaxed); }
+
+  int GetMaxThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  size_t GetTeamSize() {
+#ifdef _OPENMP
+    return static_cast<size_t>(omp_get_num_threads());
+#else
+    return 1;
+#endif
+  }
+
+  size_t GetThreadIndex() {
+#ifdef _OPENMP
+    return static_cast<size_t>(omp_get_thread_num());
+#else
+    return 0;
+#endif
+  }
+
+  size_t CalibrateElementThreshold() {  //
+
+    constexpr size_t MIN_SIZE = 1024;
+    constexpr size_t MAX_SIZE = 4 * 1024 * 1024;
+
+    size_t threshold = SIZE_MAX;
+    if (GetMaxThreads() > 1) {
+      std::vector<float> x(MAX_SIZE, 1.0f);
+      std::vector<float> y(MAX_SIZE, 2.0f);
+
+      for (size_t size = MIN_SIZE; size <= MAX_SIZE; size *= 2) {  //
+
+        const long long serial = MeasureBest([&]() {
+          for (size_t i = 0; i < size; ++i) {
+            y[i] = 0.5f * x[i] + y[i];
+          }
+        });
+
+        const long long parallel = MeasureBest([&]() {
+#pragma omp parallel for schedule(static)
+          for (int i = 0; i < static_cast<int>(size); ++i) {
+            y[i] = 0.5f * x[i] + y[i];
+          }
+        });
+
+        if (parallel < serial) {
+          threshold = size;
+          break;
+        }
+      }
+    }
+
+    SetElementThreshold(threshold);
+    return threshold;
+  }
+}  // namespace nnn::Parallel
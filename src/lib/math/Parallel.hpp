@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+
+namespace nnn::Parallel {
+
+  /**
+   * @brief Element-wise loops are split into chunks of this many elements, both for the work distribution and for
+   * reductions, so that the result of a reduction does not depend on the number of threads.
+   */
+  constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+  /**
+   * @brief Operations touching fewer elements than the threshold run serially, so that small matrices (e.g. bias
+   * vectors) do not pay the OpenMP fork/join cost.
+   */
+  size_t GetElementThreshold();
+  void SetElementThreshold(size_t threshold);
+
+  /**
+   * @brief Measures a simple element-wise loop serially and in parallel for growing sizes and sets the threshold to
+   * the smallest size for which the parallel version is faster. Takes a few milliseconds.
+   *
+   * @return the new threshold (SIZE_MAX when parallel execution never pays off, e.g. on a single core)
+   */
+  size_t CalibrateElementThreshold();
+
+  int GetMaxThreads();
+
+  /**
+   * @brief The number of threads of the innermost parallel region and the index of the calling thread in it (1 and 0
+   * outside of parallel regions).
+   */
+  size_t GetTeamSize();
+  size_t GetThreadIndex();
+
+  inline bool ShouldParallelize(size_t elements) { return elements >= GetElementThreshold() && GetMaxThreads() > 1; }
+
+  /**
+   * @brief Calls body(i) for every i in [0, count), in parallel when the whole loop touches enough elements.
+   */
+  template <typename Body>
+  void For(size_t count, size_t elements, Body&& body) {  //
+
+    if (ShouldParallelize(elements) && count > 1) {
+#pragma omp parallel for schedule(static)
+      for (int i = 0; i < static_cast<int>(count); ++i) {
+        body(static_cast<size_t>(i));
+      }
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        body(i);
+      }
+    }
+  }
+
+  /**
+   * @brief Calls body(begin, end) for consecutive ranges of [0, size) of at most CHUNK_SIZE elements. The inner loop
+   * of the body is a plain loop over a contiguous range, which the compiler vectorizes.
+   */
+  template <typename Body>
+  void ForChunks(size_t size, Body&& body) {  //
+
+    if (!ShouldParallelize(size)) {
+      body(size_t(0), size);
+      return;
+    }
+
+    const size_t chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+#pragma omp parallel for schedule(static)
+    for (int chunk = 0; chunk < static_cast<int>(chunks); ++chunk) {
+      const size_t begin = chunk * CHUNK_SIZE;
+      body(begin, begin + CHUNK_SIZE < size ? begin + CHUNK_SIZE : size);
+    }
+  }
+
+  /**
+   * @brief Calls body(worker) for every worker in [0, count), each on its own thread (when OpenMP is available), for
+   * coarse-grained work like training one model replica per thread. Parallel loops inside the body run serially (nested
+   * parallelism is off by default). The first exception thrown by any worker is rethrown once all of them finished.
+   */
+  template <typename Body>
+  void ForEachWorker(size_t count, Body&& body) {  //
+
+    // a single worker keeps the parallel loops inside the body parallel
+    if (count == 1) {
+      body(size_t(0));
+      return;
+    }
+
+    std::exception_ptr error = nullptr;
+#pragma omp parallel for schedule(static, 1) num_threads(static_cast<int>(count))
+    for (int worker = 0; worker < static_cast<int>(count); ++worker) {
+      try {
+        body(static_cast<size_t>(worker));
+      } catch (...) {
+#pragma omp critical(nnnParallelWorkerError)
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  /**
+   * @brief Like ForEachWorker, but for workers that wait for each other and therefore have to run at the same time.
+   * OpenMP may start fewer threads than asked for (OMP_THREAD_LIMIT, OMP_DYNAMIC, nested regions, no OpenMP), in that
+   * case the body is not called at all and the caller has to do the work another way.
+   *
+   * @returns whether every worker ran on its own thread
+   */
+  template <typename Body>
+  bool TryForEachConcurrentWorker(size_t count, Body&& body) {  //
+
+    if (count == 1) {
+      body(size_t(0));
+      return true;
+    }
+
+    // all threads of the team see the same team size, so either all of them run the body or none
+    bool isConcurrent = false;
+    std::exception_ptr error = nullptr;
+#pragma omp parallel num_threads(static_cast<int>(count))
+    {
+      if (GetTeamSize() == count) {
+        const size_t worker = GetThreadIndex();
+        if (worker == 0) {
+          isConcurrent = true;
+        }
+        try {
+          body(worker);
+        } catch (...) {
+#pragma omp critical(nnnParallelWorkerError)
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return isConcurrent;
+  }
+}  // namespace nnn::Parallel
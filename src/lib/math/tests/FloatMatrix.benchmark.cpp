@@ -4,11 +4,14 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
+#include <functional>
 #include <iostream>
+#include <string>
 
 #include <omp.h>
 
 #include "FloatMatrix.hpp"
+#include "GemmKernels.hpp"
 
 TEST_CASE("Matrix multiplication performance") {
   auto a = nnn::FloatMatrix::Random(784, 176, -1.0f, 1.0f);
@@ -25,6 +28,54 @@ TEST_CASE("Matrix multiplication performance") {
     omp_set_num_threads(4);
     return a * b;
   };
+
+  omp_set_num_threads(num_threads);
+}
+
+TEST_CASE("Matrix multiplication kernels performance") {
+  // Shapes of the products in the first two layers of the default configuration (batch size 100).
+  auto w1 = nnn::FloatMatrix::Random(186, 784, -1.0f, 1.0f);
+  auto x1 = nnn::FloatMatrix::Random(784, 100, -1.0f, 1.0f);
+  auto w2 = nnn::FloatMatrix::Random(84, 186, -1.0f, 1.0f);
+  auto x2 = nnn::FloatMatrix::Random(186, 100, -1.0f, 1.0f);
+
+  const nnn::Gemm::Kernel defaultKernel = nnn::Gemm::GetActiveKernel();
+
+  for (const auto& kernel : nnn::Gemm::GetAvailableKernels()) {
+    nnn::Gemm::SetActiveKernel(kernel);
+    std::string name = kernel.name;
+
+    BENCHMARK("Serial 186x784 * 784x100 (" + name + ")") { return w1.MultiplySerial(x1); };
+    BENCHMARK("Parallel 186x784 * 784x100 (" + name + ")") { return w1 * x1; };
+    BENCHMARK("Serial 84x186 * 186x100 (" + name + ")") { return w2.MultiplySerial(x2); };
+  }
+
+  nnn::Gemm::SetActiveKernel(defaultKernel);
+}
+
+TEST_CASE("Element-wise mapping performance") {
+  // Hidden layer activations of the default configuration (batch size 100) and a tenth of the training set.
+  auto activations = nnn::FloatMatrix::Random(186, 100, -1.0f, 1.0f);
+  auto features = nnn::FloatMatrix::Random(784, 6000, 0.0f, 255.0f);
+  const float alpha = 0.01f;
+
+  // Passing std::function reproduces the former type-erased implementation: one indirect call per element.
+  const std::function<float(float)> erasedLeakyReLU = [alpha](float x) { return x > 0 ? x : x * alpha; };
+  const std::function<float(float)> erasedIdentity = [](float x) { return x; };
+
+  BENCHMARK("LeakyReLU 186x100 (std::function)") { return activations.Map(erasedLeakyReLU); };
+  BENCHMARK("LeakyReLU 186x100 (inlined)") {
+    return activations.Map([alpha](float x) { return x > 0 ? x : x * alpha; });
+  };
+
+  BENCHMARK("Normalization 784x6000 (std::function)") {
+    const std::function<float(float)> normalize = [](float x) { return x / 255.0f; };
+    return features.Map(normalize);
+  };
+  BENCHMARK("Normalization 784x6000 (inlined)") { return features.Map([](float x) { return x / 255.0f; }); };
+
+  BENCHMARK("Sum 784x6000 (std::function)") { return features.Aggregate<float>(erasedIdentity); };
+  BENCHMARK("Sum 784x6000 (inlined)") { return features.Aggregate<float>([](float x) { return x; }); };
 }
 
 #else
@@ -1,7 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <random>
+#include <string>
 
 #ifdef _OPENMP
 #include <thread>
@@ -10,6 +16,9 @@
 
 #include "ColumnMajorFloatMatrixIterator.hpp"
 #include "FloatMatrix.hpp"
+#include "GemmKernels.hpp"
+#include "MatrixExpression.hpp"
+#include "Parallel.hpp"
 #include "RowMajorFloatMatrixIterator.hpp"
 
 TEST_CASE("Initialization") {
@@ -593,6 +602,12 @@ TEST_CASE("Function mapping and aggregating to basic matrix") {
 
   int count = squared.Aggregate<int>([](float x) { return x >= 0.0f ? 1 : 0; });
   CHECK(count == 1);
+
+  a.Transpose();
+  nnn::FloatMatrix mapped = a.Map([](float x) { return x * 2.0f; });
+  CHECK(mapped.IsTransposed());
+  CHECK(mapped(0, 1) == 6.0f);
+  CHECK(mapped(1, 0) == 4.0f);
 }
 
 TEST_CASE("Matrix column sum") {
@@ -650,3 +665,388 @@ TEST_CASE("Copy columns") {
     CHECK(columns.GetRowCount() == 0);
   }
 }
+
+TEST_CASE("Blocked matrix multiplication with odd shapes and transposed operands") {
+  // Shapes chosen to cross the register, L1/L2 and L3 block boundaries of the GEMM engine.
+  const std::vector<std::array<size_t, 3>> shapes = {{1, 1, 1}, {5, 3, 9}, {13, 300, 17}, {130, 7, 513}, {3, 2100, 4}};
+
+  for (const auto& [m, k, n] : shapes) {
+    for (int layout = 0; layout < 4; ++layout) {
+      bool transposeA = layout & 1;
+      bool transposeB = layout & 2;
+
+      auto a = nnn::FloatMatrix::Random(transposeA ? k : m, transposeA ? m : k, -1.0f, 1.0f);
+      auto b = nnn::FloatMatrix::Random(transposeB ? n : k, transposeB ? k : n, -1.0f, 1.0f);
+      if (transposeA) a.Transpose();
+      if (transposeB) b.Transpose();
+
+      auto ab = a * b;
+      REQUIRE(ab.GetRowCount() == m);
+      REQUIRE(ab.GetColCount() == n);
+      CHECK(ab == a.MultiplySerial(b));
+
+      double maxError = 0.0;
+      for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+          double expected = 0.0;
+          for (size_t p = 0; p < k; ++p) {
+            expected += static_cast<double>(a(i, p)) * b(p, j);
+          }
+          maxError = std::max(maxError, std::abs(expected - ab(i, j)));
+        }
+      }
+      CHECK(maxError < 1e-3);
+    }
+  }
+}
+
+TEST_CASE("Vectorized GEMM kernels match the scalar kernel") {
+  const std::vector<nnn::Gemm::Kernel>& kernels = nnn::Gemm::GetAvailableKernels();
+  const nnn::Gemm::Kernel defaultKernel = nnn::Gemm::GetActiveKernel();
+
+  std::string kernelNames;
+  for (const auto& kernel : kernels) {
+    kernelNames += std::string(" ") + kernel.name;
+  }
+  INFO("Available GEMM kernels:" << kernelNames << " (active: " << defaultKernel.name << ")");
+
+  CHECK(std::string(kernels.front().name) == nnn::Gemm::GetScalarKernel().name);
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<size_t> dimension(1, 300);
+
+  for (int round = 0; round < 10; ++round) {
+    size_t m = dimension(rng);
+    size_t k = dimension(rng);
+    size_t n = dimension(rng);
+
+    auto a = nnn::FloatMatrix::Random(m, k, -1.0f, 1.0f);
+    auto b = nnn::FloatMatrix::Random(k, n, -1.0f, 1.0f);
+    if (round % 2 == 1) {
+      b = nnn::FloatMatrix::Random(n, k, -1.0f, 1.0f);
+      b.Transpose();
+    }
+
+    nnn::Gemm::SetActiveKernel(nnn::Gemm::GetScalarKernel());
+    auto expected = a.MultiplySerial(b);
+
+    for (const auto& kernel : kernels) {
+      nnn::Gemm::SetActiveKernel(kernel);
+      auto parallel = a * b;
+      auto serial = a.MultiplySerial(b);
+
+      CHECK(parallel == serial);
+
+      float maxError = 0.0f;
+      for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+          maxError = std::max(maxError, std::abs(serial(i, j) - expected(i, j)));
+        }
+      }
+      INFO("kernel " << kernel.name << ", shape " << m << "x" << k << " * " << k << "x" << n);
+      CHECK(maxError < 1e-4f);
+    }
+  }
+
+  nnn::Gemm::SetActiveKernel(defaultKernel);
+}
+
+TEST_CASE("Multiplication with implicitly transposed operand") {
+  auto a = nnn::FloatMatrix::Random(37, 300, -1.0f, 1.0f);
+  auto b = nnn::FloatMatrix::Random(37, 21, -1.0f, 1.0f);
+  auto c = nnn::FloatMatrix::Random(45, 300, -1.0f, 1.0f);
+
+  auto aT = a;
+  aT.Transpose();
+  auto cT = c;
+  cT.Transpose();
+
+  auto transA = a.MultiplyTransA(b);
+  CHECK(transA.GetRowCount() == 300);
+  CHECK(transA.GetColCount() == 21);
+  CHECK_FALSE(a.IsTransposed());
+  CHECK(transA == aT * b);
+
+  auto transB = a.MultiplyTransB(c);
+  CHECK(transB.GetRowCount() == 37);
+  CHECK(transB.GetColCount() == 45);
+  CHECK_FALSE(c.IsTransposed());
+  CHECK(transB == a * cT);
+
+  // Works the same when the operands already carry the transposition flag.
+  CHECK(aT.MultiplyTransA(transA) == a * transA);
+
+  REQUIRE_THROWS(a.MultiplyTransA(c));
+  REQUIRE_THROWS(a.MultiplyTransB(b));
+}
+
+TEST_CASE("Output-parameter operations reuse the destination") {
+  auto a = nnn::FloatMatrix::Random(20, 30, -1.0f, 1.0f);
+  auto b = nnn::FloatMatrix::Random(30, 10, -1.0f, 1.0f);
+  auto c = nnn::FloatMatrix::Random(20, 30, -1.0f, 1.0f);
+
+  nnn::FloatMatrix product(0, 0);
+  nnn::FloatMatrix::MultiplyInto(product, a, b);
+  CHECK(product == a * b);
+
+  const float* storage = product.Data();
+  nnn::FloatMatrix::MultiplyInto(product, a, b, 2.0f, 1.0f);
+  CHECK(product.Data() == storage);
+  CHECK(product == (a * b) * 3.0f);
+
+  nnn::FloatMatrix sum(0, 0);
+  nnn::FloatMatrix::AddInto(sum, a, c, 1.0f, -0.5f);
+  CHECK(sum == a - c * 0.5f);
+
+  storage = sum.Data();
+  nnn::FloatMatrix::HadamardInto(sum, a, c);
+  CHECK(sum.Data() == storage);
+  CHECK(sum == a.Hadamard(c));
+
+  // The destination may be an operand of element-wise operations.
+  auto accumulated = a;
+  nnn::FloatMatrix::AddInto(accumulated, accumulated, c, 0.5f, 1.0f);
+  CHECK(accumulated == a * 0.5f + c);
+
+  auto cT = c;
+  cT.Transpose();
+  nnn::FloatMatrix columnSum(0, 0);
+  nnn::FloatMatrix::SumColumnsInto(columnSum, a);
+  nnn::FloatMatrix::SumColumnsInto(columnSum, a, -1.0f, 1.0f);
+  CHECK(columnSum == nnn::FloatMatrix::Zeroes(20, 1));
+
+  nnn::FloatMatrix transposedSum(0, 0);
+  nnn::FloatMatrix::SumColumnsInto(transposedSum, cT);
+  CHECK(transposedSum == nnn::FloatMatrix::SumColumns(cT));
+
+  nnn::FloatMatrix transB(0, 0);
+  nnn::FloatMatrix::MultiplyTransBInto(transB, a, c);
+  CHECK(transB == a.MultiplyTransB(c));
+  nnn::FloatMatrix transA(0, 0);
+  nnn::FloatMatrix::MultiplyTransAInto(transA, a, c);
+  CHECK(transA == a.MultiplyTransA(c));
+
+  REQUIRE_THROWS(nnn::FloatMatrix::MultiplyInto(a, a, b));
+  REQUIRE_THROWS(nnn::FloatMatrix::MultiplyInto(transA, a, b, 1.0f, 1.0f));
+}
+
+TEST_CASE("Gathering columns keeps the layout of the source") {
+  auto matrix = nnn::FloatMatrix::Create(2, 4, {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f}).value();
+  auto transposed = matrix;
+  transposed.Transpose();
+
+  nnn::FloatMatrix columns(0, 0);
+  nnn::FloatMatrix::GatherColumnsInto(columns, transposed, 1, 1);
+  CHECK(columns.IsTransposed());
+  CHECK(columns.GetRowCount() == 4);
+  CHECK(columns.GetColCount() == 1);
+  CHECK(columns(0, 0) == 5);
+  CHECK(columns(3, 0) == 8);
+
+  nnn::FloatMatrix::GatherColumnsInto(columns, transposed, 0, 1);
+  CHECK(columns == transposed);
+
+  const float* storage = columns.Data();
+  nnn::FloatMatrix::GatherColumnsInto(columns, transposed, {1, 0});
+  CHECK(columns.Data() == storage);
+  CHECK(columns(0, 0) == 5);
+  CHECK(columns(0, 1) == 1);
+  CHECK(columns(2, 1) == 3);
+}
+
+TEST_CASE("Lazy element-wise expressions") {
+  auto weights = nnn::FloatMatrix::Random(17, 9, -1.0f, 1.0f);
+  auto velocity = nnn::FloatMatrix::Random(17, 9, -1.0f, 1.0f);
+  auto gradient = nnn::FloatMatrix::Random(17, 9, -1.0f, 1.0f);
+
+  nnn::FloatMatrix expected = weights * 0.9f - (velocity * 0.5f + gradient) * 0.01f;
+  nnn::FloatMatrix result = nnn::Lazy(weights) * 0.9f - (nnn::Lazy(velocity) * 0.5f + gradient) * 0.01f;
+  CHECK(result == expected);
+
+  // The destination may appear in the expression.
+  expected = velocity * 0.5f + gradient;
+  velocity = nnn::Lazy(velocity) * 0.5f + gradient;
+  CHECK(velocity == expected);
+
+  // Operands with different layouts are evaluated element by element.
+  auto transposed = nnn::FloatMatrix::Random(9, 17, -1.0f, 1.0f);
+  transposed.Transpose();
+  expected = weights.Hadamard(transposed) - gradient;
+  result = nnn::Hadamard(nnn::Lazy(weights), transposed) - gradient;
+  CHECK(result == expected);
+
+  REQUIRE_THROWS_AS(nnn::Lazy(weights) + nnn::FloatMatrix(9, 17), nnn::FloatMatrixInvalidDimensionException);
+}
+
+TEST_CASE("Aligned and padded storage") {
+  auto small = nnn::FloatMatrix::Random(3, 5);
+  CHECK(reinterpret_cast<uintptr_t>(small.Data()) % nnn::STORAGE_ALIGNMENT == 0);
+  auto large = nnn::FloatMatrix(784, 1000);
+  const size_t largeAlignment = nnn::AreHugePagesAvailable() ? nnn::HUGE_PAGE_SIZE : nnn::STORAGE_ALIGNMENT;
+  CHECK(reinterpret_cast<uintptr_t>(large.Data()) % largeAlignment == 0);
+
+  CHECK(nnn::FloatMatrix::GetPaddedLeadingDimension(10) == 16);
+  CHECK(nnn::FloatMatrix::GetPaddedLeadingDimension(784) == 784);
+  CHECK(nnn::FloatMatrix::GetPaddedLeadingDimension(256) == 272);
+
+  auto a = nnn::FloatMatrix::Random(37, 50, -1.0f, 1.0f);
+  auto b = nnn::FloatMatrix::Random(50, 23, -1.0f, 1.0f);
+  auto paddedA = nnn::FloatMatrix::ZeroesPadded(37, 50);
+  auto paddedB = nnn::FloatMatrix::ZeroesPadded(50, 23);
+  paddedA = nnn::Lazy(paddedA) + a;
+  paddedB = nnn::Lazy(paddedB) + b;
+
+  REQUIRE_FALSE(paddedA.IsContiguous());
+  CHECK(paddedA.GetLeadingDimension() == 64);
+  CHECK(paddedA.GetRowStride() == 64);
+  for (size_t r = 0; r < 37; ++r) {
+    CHECK(reinterpret_cast<uintptr_t>(paddedA.Data() + r * paddedA.GetRowStride()) % nnn::STORAGE_ALIGNMENT == 0);
+  }
+
+  CHECK(paddedA == a);
+  CHECK(paddedA * paddedB == a * b);
+  CHECK(paddedA + a == a * 2.0f);
+  CHECK(paddedA.Map([](float x) { return x * x; }) == a.Hadamard(a));
+  CHECK(std::abs(paddedA.Aggregate<float>([](float x) { return x; }) - a.Aggregate<float>([](float x) { return x; })) <
+        1e-4f);
+  CHECK(nnn::FloatMatrix::SumColumns(paddedA) == nnn::FloatMatrix::SumColumns(a));
+  CHECK(paddedA.GetColumns({3, 7}) == a.GetColumns({3, 7}));
+
+  paddedB.Transpose();
+  auto bT = b;
+  bT.Transpose();
+  CHECK(paddedB.GetLeadingDimension() == 32);
+  CHECK(paddedB == bT);
+  CHECK(paddedB.GetColumns(2, 40) == bT.GetColumns(2, 40));
+  CHECK(nnn::FloatMatrix::SumColumns(paddedB) == nnn::FloatMatrix::SumColumns(bT));
+  CHECK(a.MultiplyTransB(paddedB) == a * b);
+}
+
+TEST_CASE("Column views share the storage of the matrix") {
+  auto matrix = nnn::FloatMatrix::Random(6, 40, -1.0f, 1.0f);
+  auto transposed = nnn::FloatMatrix::Random(40, 6, -1.0f, 1.0f);
+  transposed.Transpose();
+
+  for (const nnn::FloatMatrix* source : {&matrix, &transposed}) {
+    nnn::FloatMatrixView view = source->ViewColumns(5, 24);
+    CHECK(view.GetRowCount() == 6);
+    CHECK(view.GetColCount() == 20);
+    CHECK(view.IsTransposed() == source->IsTransposed());
+    CHECK(&view(0, 0) == &(*source)(0, 5));
+    CHECK(&view(5, 19) == &(*source)(5, 24));
+
+    // Views are accepted by the read-only kernels and materialize into the same values as a copy.
+    nnn::FloatMatrix copy = source->GetColumns(5, 24);
+    CHECK(nnn::FloatMatrix(view) == copy);
+    CHECK(nnn::FloatMatrix(view.GetColumns(2, 3)) == source->GetColumns(7, 8));
+
+    auto weights = nnn::FloatMatrix::Random(3, 6, -1.0f, 1.0f);
+    nnn::FloatMatrix product(0, 0);
+    nnn::FloatMatrix::MultiplyInto(product, weights, view);
+    CHECK(product == weights * copy);
+
+    // Evaluated expressions are row-major, whatever the layout of the operands.
+    nnn::FloatMatrix sum = nnn::Lazy(view) * 2.0f - copy;
+    nnn::FloatMatrix expected = nnn::Lazy(copy) * 1.0f;
+    CHECK(sum == expected);
+  }
+
+  nnn::FloatMatrix destination = matrix;
+  REQUIRE_THROWS(nnn::FloatMatrix::MultiplyInto(destination, nnn::FloatMatrix::Ones(40, 6), destination.View()));
+  REQUIRE_THROWS(nnn::FloatMatrix::GatherColumnsInto(destination, destination.ViewColumns(1, 2), {0}));
+}
+
+TEST_CASE("Matrices can live in external storage") {
+  auto source = nnn::FloatMatrix::Random(5, 3, -1.0f, 1.0f);
+  nnn::FloatMatrix matrix = source;
+  matrix.Transpose();
+  const nnn::FloatMatrix expected = nnn::Lazy(matrix) * 1.0f;  // row-major
+
+  // The values are kept and stored row-major, whatever the previous layout.
+  std::vector<float> buffer(15);
+  matrix.MoveToExternalStorage(buffer.data());
+  CHECK(matrix.HasExternalStorage());
+  CHECK(!matrix.IsTransposed());
+  CHECK(matrix == expected);
+  CHECK(matrix.Data() == buffer.data());
+  CHECK(buffer[1] == expected(0, 1));
+
+  matrix(2, 4) = 42.0f;
+  CHECK(buffer[2 * 5 + 4] == 42.0f);
+
+  // Copies own their storage, assignments into the matrix write to the buffer.
+  nnn::FloatMatrix copy = matrix;
+  CHECK(!copy.HasExternalStorage());
+  copy(0, 0) = 7.0f;
+  CHECK(buffer[0] != 7.0f);
+
+  matrix = nnn::FloatMatrix::Ones(3, 5);
+  CHECK(matrix.Data() == buffer.data());
+  CHECK(buffer[14] == 1.0f);
+
+  nnn::FloatMatrix::AddInto(matrix, matrix, matrix, 1.0f, 1.0f);
+  CHECK(buffer[7] == 2.0f);
+
+  REQUIRE_THROWS(matrix = nnn::FloatMatrix::Ones(5, 5));
+  REQUIRE_THROWS(matrix.EnsureShape(4, 5));
+
+  // Moves take the buffer over without copying it.
+  nnn::FloatMatrix moved = std::move(matrix);
+  CHECK(moved.Data() == buffer.data());
+  CHECK(matrix.GetSize() == 0);
+  CHECK(!matrix.HasExternalStorage());
+
+  copy = std::move(moved);
+  CHECK(copy.Data() == buffer.data());
+  CHECK(copy(1, 2) == 2.0f);
+}
+
+TEST_CASE("Element-wise operations give the same results serially and in parallel") {  //
+
+  struct Results {
+    nnn::FloatMatrix sum, hadamard, expression, mapped, shifted, gathered, columnSum, transposedColumnSum;
+    float aggregate;
+  };
+
+  // wider than a few chunks and with an odd number of rows, so that the last chunk and row block are partial
+  auto a = nnn::FloatMatrix::Random(187, 301, -1.0f, 1.0f);
+  auto b = nnn::FloatMatrix::Random(187, 301, -1.0f, 1.0f);
+  auto transposed = nnn::FloatMatrix::Random(301, 187, -1.0f, 1.0f);
+  transposed.Transpose();
+  auto bias = nnn::FloatMatrix::Random(187, 1, -1.0f, 1.0f);
+
+  auto compute = [&]() {
+    Results results{a + b, a.Hadamard(b), nnn::Lazy(a) * 0.5f - b, a.Map([](float x) { return x * x; }), a,
+        transposed.GetColumns(3, 250), nnn::FloatMatrix::SumColumns(a), nnn::FloatMatrix::SumColumns(transposed),
+        a.Aggregate<float>([](float x) { return x; })};
+    results.shifted.AddToAllCols(bias);
+    return results;
+  };
+
+  const size_t threshold = nnn::Parallel::GetElementThreshold();
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(4);
+#endif
+
+  nnn::Parallel::SetElementThreshold(SIZE_MAX);
+  Results serial = compute();
+  nnn::Parallel::SetElementThreshold(0);
+  Results parallel = compute();
+
+  nnn::Parallel::SetElementThreshold(threshold);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  CHECK(parallel.sum == serial.sum);
+  CHECK(parallel.hadamard == serial.hadamard);
+  CHECK(parallel.expression == serial.expression);
+  CHECK(parallel.mapped == serial.mapped);
+  CHECK(parallel.shifted == serial.shifted);
+  CHECK(parallel.gathered == serial.gathered);
+  CHECK(parallel.columnSum == serial.columnSum);
+  CHECK(parallel.transposedColumnSum == serial.transposedColumnSum);
+  // reductions are split into chunks of fixed size, so the order of summation does not depend on the thread count
+  CHECK(parallel.aggregate == serial.aggregate);
+}